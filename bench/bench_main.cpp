@@ -0,0 +1,330 @@
+// miniBlogTUI 基准测试：启动回环地址上的模拟后端，在伪终端中运行真正的 miniBlogTUI，
+// 测量冷启动/热启动到第一帧、新文章推送到显示的时间、F5 刷新、按键重绘延迟和输出字节数、内存峰值，结果以 JSON 输出
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <pty.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "mock_server.h"
+
+#ifndef MINIBLOG_TUI_PATH
+#define MINIBLOG_TUI_PATH "./miniBlogTUI"
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+double ms_between(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// 在伪终端中运行的 miniBlogTUI 进程
+class PtyApp {
+public:
+    ~PtyApp() { kill_now(); }
+
+    bool launch(const std::string& binary, const std::string& dir, const std::string& url, int rows, int cols) {
+        winsize size{};
+        size.ws_row = rows;
+        size.ws_col = cols;
+        started_ = Clock::now();
+        pid_ = forkpty(&master_, nullptr, nullptr, &size);
+        if (pid_ < 0) return false;
+        if (pid_ == 0) {
+            if (chdir(dir.c_str()) != 0) _exit(127);
+            setenv("MINIBLOG_URL", url.c_str(), 1);
+            setenv("TERM", "xterm", 1);
+            execl(binary.c_str(), binary.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        return true;
+    }
+
+    Clock::time_point started() const { return started_; }
+    Clock::time_point first_output() const { return first_output_; }
+    pid_t pid() const { return pid_; }
+
+    void send(const std::string& keys) {
+        if (write(master_, keys.data(), keys.size()) < 0) {
+            std::cerr << "write to pty failed\n";
+        }
+    }
+
+    // 读取输出直到出现 needle，返回是否在超时前出现
+    bool wait_for(const std::string& needle, int timeout_ms, Clock::time_point& when) {
+        auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (Clock::now() < deadline) {
+            if (screen_.find(needle) != std::string::npos) {
+                when = last_read_;
+                return true;
+            }
+            read_some(static_cast<int>(ms_between(Clock::now(), deadline)) + 1);
+        }
+        return false;
+    }
+
+    // 读取输出直到连续 settle_ms 没有新数据，返回读取的字节数
+    size_t drain(int settle_ms, int timeout_ms, Clock::time_point& last) {
+        auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+        size_t total = 0;
+        last = Clock::now();
+        while (Clock::now() < deadline) {
+            size_t n = read_some(settle_ms);
+            if (n == 0) break;
+            total += n;
+            last = last_read_;
+        }
+        return total;
+    }
+
+    // 进程的内存峰值（VmHWM，KB）
+    long peak_rss_kb() const {
+        std::ifstream status("/proc/" + std::to_string(pid_) + "/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("VmHWM:", 0) == 0) return std::atol(line.c_str() + 6);
+        }
+        return -1;
+    }
+
+    // 按 q 退出并等待进程结束
+    bool quit(int timeout_ms) {
+        send("q");
+        auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (Clock::now() < deadline) {
+            read_some(10);
+            int status;
+            if (waitpid(pid_, &status, WNOHANG) == pid_) {
+                pid_ = -1;
+                close(master_);
+                return true;
+            }
+        }
+        kill_now();
+        return false;
+    }
+
+    void clear_screen_buffer() { screen_.clear(); }
+
+private:
+    size_t read_some(int timeout_ms) {
+        pollfd pfd{master_, POLLIN, 0};
+        if (poll(&pfd, 1, timeout_ms) <= 0) return 0;
+        char buffer[65536];
+        ssize_t n = read(master_, buffer, sizeof(buffer));
+        if (n <= 0) return 0;
+        last_read_ = Clock::now();
+        if (first_output_ == Clock::time_point{}) first_output_ = last_read_;
+        screen_.append(buffer, n);
+        if (screen_.size() > (1 << 20)) screen_.erase(0, screen_.size() - (1 << 19));  // 只保留最近的输出
+        return n;
+    }
+
+    void kill_now() {
+        if (pid_ > 0) {
+            kill(pid_, SIGKILL);
+            waitpid(pid_, nullptr, 0);
+            close(master_);
+            pid_ = -1;
+        }
+    }
+
+    pid_t pid_ = -1;
+    int master_ = -1;
+    std::string screen_;
+    Clock::time_point started_;
+    Clock::time_point first_output_{};
+    Clock::time_point last_read_;
+};
+
+nlohmann::json summarize(std::vector<double> samples) {
+    if (samples.empty()) return nullptr;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples) sum += s;
+    auto percentile = [&](double p) { return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))]; };
+    return {{"count", samples.size()}, {"mean", sum / samples.size()}, {"p50", percentile(0.5)},
+            {"p99", percentile(0.99)}, {"max", samples.back()}};
+}
+
+// 连续发送同一个按键，测量每次按键到输出结束的延迟和输出的字节数
+nlohmann::json measure_keystrokes(PtyApp& app, const std::string& key, int count) {
+    std::vector<double> latency, bytes;
+    for (int i = 0; i < count; ++i) {
+        auto sent = Clock::now();
+        app.send(key);
+        Clock::time_point last;
+        size_t n = app.drain(30, 2000, last);
+        latency.push_back(n ? ms_between(sent, last) : 0);
+        bytes.push_back(static_cast<double>(n));
+    }
+    return {{"latency_ms", summarize(latency)}, {"bytes", summarize(bytes)}};
+}
+
+void usage() {
+    std::cerr << "usage: miniBlogTUI_bench [--posts N] [--authors N] [--rtt-ms N] [--content-bytes N]\n"
+                 "                         [--keystrokes N] [--rows N] [--cols N] [--binary PATH] [--output FILE]\n"
+                 "                         [--no-feed] 模拟不支持 /feed 的后端\n"
+                 "                         [--content-on-demand] 列表不附带正文，翻页时才请求\n"
+                 "                         [--error-rate P] 模拟后端以概率 P 返回 503\n"
+                 "                         [--slow-rate P] [--slow-ms N] 以概率 P 额外等待 N 毫秒\n"
+                 "                         [--serve]   只运行模拟后端，直到按 Ctrl-C\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    MockConfig config;
+    int keystrokes = 50;
+    int rows = 40, cols = 120;
+    std::string binary = MINIBLOG_TUI_PATH;
+    std::string output;
+    bool serve_only = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--posts") config.posts = std::atoi(next());
+        else if (arg == "--authors") config.authors = std::atoi(next());
+        else if (arg == "--rtt-ms") config.rtt_ms = std::atoi(next());
+        else if (arg == "--content-bytes") config.content_bytes = std::atol(next());
+        else if (arg == "--keystrokes") keystrokes = std::atoi(next());
+        else if (arg == "--rows") rows = std::atoi(next());
+        else if (arg == "--cols") cols = std::atoi(next());
+        else if (arg == "--binary") binary = next();
+        else if (arg == "--output") output = next();
+        else if (arg == "--no-feed") config.feed = false;
+        else if (arg == "--content-on-demand") config.content_in_list = false;
+        else if (arg == "--error-rate") config.error_rate = std::atof(next());
+        else if (arg == "--slow-rate") config.slow_rate = std::atof(next());
+        else if (arg == "--slow-ms") config.slow_ms = std::atoi(next());
+        else if (arg == "--serve") serve_only = true;
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    MockBlogServer server(config);
+    if (!server.start()) {
+        std::cerr << "failed to start mock server\n";
+        return 1;
+    }
+    if (serve_only) {
+        std::cerr << "mock blog server listening on " << server.url() << "\n";
+        while (true) std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    char dir_template[] = "/tmp/miniblog-bench-XXXXXX";
+    if (!mkdtemp(dir_template)) {
+        std::cerr << "failed to create working directory\n";
+        return 1;
+    }
+    std::string dir = dir_template;
+    const int timeout_ms = 60000;
+    nlohmann::json result = {
+            {"config", {{"posts", config.posts}, {"authors", config.authors}, {"rtt_ms", config.rtt_ms},
+                        {"content_bytes", config.content_bytes}, {"feed", config.feed},
+                        {"content_in_list", config.content_in_list}, {"error_rate", config.error_rate},
+                        {"slow_rate", config.slow_rate}, {"slow_ms", config.slow_ms}, {"rows", rows}, {"cols", cols}}}};
+
+    // 冷启动：没有磁盘缓存
+    {
+        PtyApp app;
+        if (!app.launch(binary, dir, server.url(), rows, cols)) {
+            std::cerr << "failed to launch " << binary << "\n";
+            return 1;
+        }
+        Clock::time_point first_post;
+        bool shown = app.wait_for("Post " + std::to_string(config.posts), timeout_ms, first_post);
+        Clock::time_point last;
+        app.drain(100, timeout_ms, last);
+        result["cold_start"] = {{"first_output_ms", ms_between(app.started(), app.first_output())},
+                                {"first_post_ms", shown ? nlohmann::json(ms_between(app.started(), first_post)) : nullptr}};
+
+        result["keystrokes"] = {{"page_down", measure_keystrokes(app, "\x1b[6~", keystrokes)},
+                                {"scroll_down", measure_keystrokes(app, "\x1bOB", keystrokes)},
+                                {"scroll_up", measure_keystrokes(app, "\x1bOA", keystrokes)}};
+
+        // 输入编号 + g 跳到很靠后的文章，直到它出现在屏幕上
+        int jump = std::min(config.posts, 5000);
+        app.clear_screen_buffer();
+        auto jump_sent = Clock::now();
+        app.send(std::to_string(jump) + "g");
+        Clock::time_point jumped;
+        bool reached = app.wait_for("Post " + std::to_string(config.posts - jump + 1), timeout_ms, jumped);
+        app.drain(50, timeout_ms, last);
+        result["jump"] = {{"target", jump}, {"ms", reached ? nlohmann::json(ms_between(jump_sent, jumped)) : nullptr}};
+
+        // 服务器上新增一篇文章，不按键，等待订阅推送或定期验证把它显示出来
+        app.clear_screen_buffer();
+        auto added = Clock::now();
+        server.add_post();
+        Clock::time_point shown_at;
+        bool pushed = app.wait_for("Post " + std::to_string(config.posts + 1), timeout_ms, shown_at);
+        app.drain(50, timeout_ms, last);
+        result["live_update_ms"] = pushed ? nlohmann::json(ms_between(added, shown_at)) : nullptr;
+
+        // F5：重新验证第一页，直到请求完成且输出结束
+        uint64_t before = server.request_count("GET /posts");
+        auto sent = Clock::now();
+        app.send("\x1b[15~");
+        auto deadline = sent + std::chrono::milliseconds(timeout_ms);
+        while (server.request_count("GET /posts") == before && Clock::now() < deadline) {
+            app.drain(1, 10, last);
+        }
+        app.drain(50, timeout_ms, last);
+        result["refresh_ms"] = ms_between(sent, last);
+
+        result["peak_rss_kb"] = app.peak_rss_kb();
+        result["clean_exit"] = app.quit(5000);
+    }
+
+    // 热启动：使用上一次退出时写入的磁盘缓存；删除阅读状态，与冷启动一样从列表开头显示
+    std::filesystem::remove(dir + "/reading.state");
+    {
+        PtyApp app;
+        app.launch(binary, dir, server.url(), rows, cols);
+        Clock::time_point first_post;
+        bool shown = app.wait_for("Post " + std::to_string(config.posts + 1), timeout_ms, first_post);
+        Clock::time_point last;
+        app.drain(100, timeout_ms, last);
+        result["warm_start"] = {{"first_output_ms", ms_between(app.started(), app.first_output())},
+                                {"first_post_ms", shown ? nlohmann::json(ms_between(app.started(), first_post)) : nullptr},
+                                {"peak_rss_kb", app.peak_rss_kb()}};
+        app.quit(5000);
+    }
+
+    MockStats stats = server.stats();
+    result["backend"] = {{"requests", stats.requests}, {"connections", stats.connections}, {"bytes_sent", stats.bytes_sent},
+                         {"injected_errors", stats.injected_errors}, {"injected_delays", stats.injected_delays}};
+    server.stop();
+    std::filesystem::remove_all(dir);
+
+    std::string text = result.dump(2);
+    if (output.empty()) {
+        std::cout << text << std::endl;
+    } else {
+        std::ofstream(output) << text << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+// 正文渲染的微基准：生成 Markdown 文章，分别测量解析（render_markdown）、折行（layout_text）
+// 和按视口取样式段（每帧绘制前的工作，不调用 ncurses）的速度，每项取多次运行中最快的一次，结果以 JSON 输出
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "markdown.h"
+#include "text_layout.h"
+
+namespace {
+
+// 线程 CPU 时间，不受其他进程抢占的影响
+double cpu_ms() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+template <typename F>
+double best_of(int iterations, F&& run) {
+    double best = 1e300;
+    for (int i = 0; i < iterations; ++i) {
+        double start = cpu_ms();
+        run();
+        best = std::min(best, cpu_ms() - start);
+    }
+    return best;
+}
+
+// 由标题、带行内标记的段落、列表、引用和代码块组成的文章，cjk 为 true 时段落使用中文
+std::string make_article(size_t bytes, bool cjk) {
+    static const char* paragraphs[] = {
+            "Caching the **parsed** result means scrolling only *slices* spans, see `LayoutCache::get` and "
+            "[the notes](https://example.com/notes_on_layout) for details.",
+            "Plain sentences without any markup are the common case and should stay on the fast path of the parser.",
+            "Mixed _emphasis_, __strong__, ***both*** and an escaped \\*star\\* inside a long line that wraps twice.",
+    };
+    static const char* cjk_paragraphs[] = {
+            "解析后的**样式段**只在正文变化时计算一次，滚动时只按*视口*截取，参见 `LayoutCache` 和[说明](https://example.com)。",
+            "没有任何标记的中文段落是最常见的情况，应当走解析器的快速路径，折行时每个汉字占两列。",
+    };
+    std::string text;
+    text.reserve(bytes + 256);
+    for (int section = 0; text.size() < bytes; ++section) {
+        text += "## Section " + std::to_string(section) + "\n\n";
+        for (int i = 0; i < 3; ++i) {
+            text += cjk ? cjk_paragraphs[(section + i) % 2] : paragraphs[(section + i) % 3];
+            text += '\n';
+        }
+        text += "\n- first item with `code`\n- second item\n  1. nested *ordered* item\n\n";
+        text += "> quoted **text** from another post\n\n";
+        text += "```cpp\nfor (int i = 0; i < n; ++i) {\n\tsum += a[i] * b[i];\n}\n```\n\n";
+    }
+    return text;
+}
+
+void usage() {
+    std::cerr << "usage: miniBlogTUI_markdown_bench [--bytes N] [--width N] [--rows N] [--iterations N]\n"
+                 "                                  [--cjk] 段落使用中文 [--output FILE]\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t bytes = 1 << 20;
+    int width = 80;
+    int rows = 40;
+    int iterations = 10;
+    bool cjk = false;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--bytes") bytes = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--width") width = std::atoi(next());
+        else if (arg == "--rows") rows = std::atoi(next());
+        else if (arg == "--iterations") iterations = std::max(std::atoi(next()), 1);
+        else if (arg == "--cjk") cjk = true;
+        else if (arg == "--output") output = next();
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    std::string source = make_article(bytes, cjk);
+    StyledText body;
+    double parse_ms = best_of(iterations, [&] { body = render_markdown(source); });
+
+    std::vector<LineSpan> lines;
+    double layout_ms = best_of(iterations, [&] { lines = layout_text(body.text, width); });
+
+    // 从头到尾每次滚动一行，每帧取 rows 行的样式段；sink 防止循环被优化掉
+    size_t frames = lines.size() > static_cast<size_t>(rows) ? lines.size() - rows + 1 : 1;
+    size_t sink = 0;
+    double scroll_ms = best_of(iterations, [&] {
+        for (size_t top = 0; top < frames; ++top) {
+            for (size_t i = top; i < lines.size() && i < top + rows; ++i) {
+                size_t end = lines[i].offset + lines[i].length;
+                for (size_t run = body.run_at(lines[i].offset), pos = lines[i].offset; pos < end; ++run) {
+                    size_t next = std::min(body.run_end(run), end);
+                    sink += (next - pos) ^ body.runs[run].style;
+                    pos = next;
+                }
+            }
+        }
+    });
+
+    auto mb_per_s = [&](double ms) { return ms > 0 ? source.size() / 1e6 / (ms / 1e3) : 0.0; };
+    nlohmann::json result = {
+            {"config", {{"bytes", source.size()}, {"width", width}, {"rows", rows}, {"iterations", iterations}, {"cjk", cjk}}},
+            {"parse", {{"ms", parse_ms}, {"mb_per_s", mb_per_s(parse_ms)}}},
+            {"layout", {{"ms", layout_ms}, {"mb_per_s", mb_per_s(layout_ms)}}},
+            {"scroll", {{"frames", frames}, {"us_per_frame", scroll_ms * 1e3 / frames}}},
+            {"output", {{"text_bytes", body.text.size()}, {"runs", body.runs.size()}, {"lines", lines.size()},
+                        {"checksum", sink}}},
+    };
+
+    std::string text = result.dump(2);
+    if (output.empty()) {
+        std::cout << text << std::endl;
+    } else {
+        std::ofstream(output) << text << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,390 @@
+#include "mock_server.h"
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cctype>
+#include <functional>
+#include <chrono>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const char* reason_phrase(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 304: return "Not Modified";
+        case 404: return "Not Found";
+        case 503: return "Service Unavailable";
+        default: return "Error";
+    }
+}
+
+bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+// base64url 编码（无填充），用于生成 JWT
+std::string base64url(const std::string& in) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    std::string out;
+    uint32_t bits = 0;
+    int count = 0;
+    for (unsigned char c : in) {
+        bits = (bits << 8) | c;
+        count += 8;
+        while (count >= 6) {
+            count -= 6;
+            out.push_back(alphabet[(bits >> count) & 0x3F]);
+        }
+    }
+    if (count > 0) out.push_back(alphabet[(bits << (6 - count)) & 0x3F]);
+    return out;
+}
+
+std::string lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+    return s;
+}
+
+// 取查询参数，没有时返回默认值
+int query_int(const std::string& target, const std::string& name, int fallback) {
+    size_t query = target.find('?');
+    if (query == std::string::npos) return fallback;
+    std::string key = name + "=";
+    size_t pos = query;
+    while ((pos = target.find(key, pos + 1)) != std::string::npos) {
+        char before = target[pos - 1];
+        if (before == '?' || before == '&') {
+            return std::atoi(target.c_str() + pos + key.size());
+        }
+    }
+    return fallback;
+}
+
+}  // namespace
+
+MockBlogServer::MockBlogServer(MockConfig config) : config_(config), post_count_(config.posts) {}
+
+MockBlogServer::~MockBlogServer() {
+    stop();
+}
+
+bool MockBlogServer::start() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) return false;
+    int yes = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;  // 由系统分配端口
+    socklen_t length = sizeof(addr);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listen_fd_, 128) != 0 ||
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    port_ = ntohs(addr.sin_port);
+    running_ = true;
+    accept_thread_ = std::thread(&MockBlogServer::accept_loop, this);
+    return true;
+}
+
+void MockBlogServer::stop() {
+    if (!running_.exchange(false)) return;
+    shutdown(listen_fd_, SHUT_RDWR);
+    close(listen_fd_);
+    accept_thread_.join();
+
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        changed_.notify_all();  // 唤醒等待中的长轮询
+        for (int fd : connection_fds_) shutdown(fd, SHUT_RDWR);  // 唤醒阻塞在 recv 上的连接线程
+        threads.swap(connection_threads_);
+    }
+    for (auto& thread : threads) thread.join();
+}
+
+MockStats MockBlogServer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+uint64_t MockBlogServer::request_count(const std::string& endpoint) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = stats_.requests.find(endpoint);
+    return it != stats_.requests.end() ? it->second : 0;
+}
+
+void MockBlogServer::add_post() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++post_count_;
+    record_change_locked(post_count_);
+}
+
+void MockBlogServer::edit_post(int id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++revisions_[id];
+    record_change_locked(id);
+}
+
+void MockBlogServer::record_change_locked(int id) {
+    ++version_;
+    changes_.emplace_back(version_, id);
+    changed_.notify_all();
+}
+
+void MockBlogServer::accept_loop() {
+    while (running_) {
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            if (!running_) break;
+            continue;
+        }
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.connections;
+        connection_fds_.push_back(fd);
+        connection_threads_.emplace_back(&MockBlogServer::serve_connection, this, fd);
+    }
+}
+
+void MockBlogServer::serve_connection(int fd) {
+    std::string buffer;
+    char chunk[16384];
+    auto fill = [&](size_t size) {
+        while (buffer.size() < size) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) return false;
+            buffer.append(chunk, n);
+        }
+        return true;
+    };
+
+    while (running_) {
+        size_t header_end;
+        while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!fill(buffer.size() + 1)) {
+                header_end = std::string::npos;
+                break;
+            }
+        }
+        if (header_end == std::string::npos) break;
+
+        std::istringstream head(buffer.substr(0, header_end));
+        std::string method, target, line;
+        head >> method >> target;
+        std::getline(head, line);
+        size_t content_length = 0;
+        bool keep_alive = true;
+        std::string if_none_match, idempotency_key;
+        while (std::getline(head, line)) {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string name = lower(line.substr(0, colon));
+            std::string value = line.substr(colon + 1);
+            value.erase(0, value.find_first_not_of(' '));
+            if (!value.empty() && value.back() == '\r') value.pop_back();
+            if (name == "content-length") content_length = std::stoul(value);
+            else if (name == "connection") keep_alive = lower(value) != "close";
+            else if (name == "if-none-match") if_none_match = value;
+            else if (name == "idempotency-key") idempotency_key = value;
+        }
+        if (!fill(header_end + 4 + content_length)) break;
+        buffer.erase(0, header_end + 4 + content_length);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(config_.rtt_ms));  // 模拟网络往返
+
+        bool slow = false, fail = false;
+        if (target.rfind("/feed", 0) != 0) {
+            draw_faults(slow, fail);
+        }
+        if (slow) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(config_.slow_ms));
+        }
+        Response response = fail ? Response{503, "{\"error\":\"injected\"}", ""}
+                                 : route(method, target, if_none_match, idempotency_key);
+        std::string out = "HTTP/1.1 " + std::to_string(response.status) + " " + reason_phrase(response.status) + "\r\n";
+        out += "Content-Type: application/json\r\n";
+        if (!response.etag.empty()) out += "ETag: " + response.etag + "\r\n";
+        out += "Content-Length: " + std::to_string(response.status == 304 ? 0 : response.body.size()) + "\r\n";
+        out += keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+        if (response.status != 304) out += response.body;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.bytes_sent += out.size();
+        }
+        if (!send_all(fd, out) || !keep_alive) break;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    connection_fds_.erase(std::remove(connection_fds_.begin(), connection_fds_.end(), fd), connection_fds_.end());
+    close(fd);
+}
+
+MockBlogServer::Response MockBlogServer::route(const std::string& method, const std::string& target, const std::string& if_none_match,
+                                               const std::string& idempotency_key) {
+    std::string path = target.substr(0, target.find('?'));
+
+    if (method == "POST" && path == "/login") {
+        count("POST /login");
+        if (config_.token_ttl_seconds <= 0) {
+            return {200, R"({"access_token":"mock-token","token_type":"bearer"})", ""};
+        }
+        // 签名不校验，只需要客户端能解出 exp
+        int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        nlohmann::json claims = {{"sub", "mock"}, {"iat", now}, {"exp", now + config_.token_ttl_seconds}};
+        std::string token = base64url(R"({"alg":"none","typ":"JWT"})") + "." + base64url(claims.dump()) + ".mock";
+        return {200, nlohmann::json{{"access_token", token}, {"token_type", "bearer"}}.dump(), ""};
+    }
+    if (method == "POST" && path == "/posts") {
+        count("POST /posts");
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 相同 Idempotency-Key 的重试返回第一次创建的文章，不再重复创建
+        if (!idempotency_key.empty()) {
+            auto it = idempotency_keys_.find(idempotency_key);
+            if (it != idempotency_keys_.end()) return {201, "{\"id\":" + std::to_string(it->second) + "}", ""};
+        }
+        ++post_count_;
+        record_change_locked(post_count_);
+        if (!idempotency_key.empty()) idempotency_keys_[idempotency_key] = post_count_;
+        return {201, "{\"id\":" + std::to_string(post_count_) + "}", ""};
+    }
+    if (method != "GET") {
+        return {404, R"({"detail":"Not Found"})", ""};
+    }
+
+    if (path == "/posts") {
+        count("GET /posts");
+        int count, version;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            count = post_count_;
+            version = static_cast<int>(version_);
+        }
+        int skip = std::max(query_int(target, "skip", 0), 0);
+        int limit = std::max(query_int(target, "limit", 100), 0);
+        std::string etag = "\"v" + std::to_string(version) + "-" + std::to_string(skip) + "-" + std::to_string(limit) + "\"";
+        if (!if_none_match.empty() && if_none_match == etag) {
+            return {304, "", etag};
+        }
+        // 最新的文章在前
+        std::string body = "[";
+        for (int i = skip; i < std::min(skip + limit, count); ++i) {
+            if (i > skip) body += ",";
+            body += post_json(count - i, config_.content_in_list);
+        }
+        body += "]";
+        return {200, body, etag};
+    }
+    if (path == "/feed" && config_.feed) {
+        count("GET /feed");
+        return feed(target);
+    }
+    if (path.rfind("/posts/", 0) == 0) {
+        count("GET /posts/{id}");
+        int id = std::atoi(path.c_str() + 7);
+        return {200, post_json(id, true), ""};
+    }
+    if (path.rfind("/users/", 0) == 0) {
+        count("GET /users/{id}");
+        int id = std::atoi(path.c_str() + 7);
+        if (id < 1 || id > config_.authors) return {404, R"({"detail":"User not found"})", ""};
+        return {200, nlohmann::json{{"id", id}, {"username", "author_" + std::to_string(id)}}.dump(), ""};
+    }
+    return {404, R"({"detail":"Not Found"})", ""};
+}
+
+// 没有 since 时立即返回当前游标；否则等待到有新的变更或超时，返回此后新增或修改的文章
+MockBlogServer::Response MockBlogServer::feed(const std::string& target) {
+    int since = query_int(target, "since", -1);
+    int timeout = std::clamp(query_int(target, "timeout", 25), 0, 60);
+    std::vector<int> ids;
+    uint64_t cursor;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (since >= 0) {
+            changed_.wait_for(lock, std::chrono::seconds(timeout),
+                              [&] { return version_ > static_cast<uint64_t>(since) || !running_; });
+            for (auto it = changes_.rbegin(); it != changes_.rend() && it->first > static_cast<uint64_t>(since); ++it) {
+                ids.push_back(it->second);
+            }
+        }
+        cursor = version_;
+    }
+    std::sort(ids.begin(), ids.end(), std::greater<int>());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::string body = "{\"cursor\":" + std::to_string(cursor) + ",\"posts\":[";
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (i > 0) body += ",";
+        body += post_json(ids[i], true);
+    }
+    body += "]}";
+    return {200, body, ""};
+}
+
+std::string MockBlogServer::post_json(int id, bool with_content) const {
+    int revision;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = revisions_.find(id);
+        revision = it != revisions_.end() ? it->second : 0;
+    }
+    std::string title = "Post " + std::to_string(id);
+    if (revision > 0) {
+        title += " (rev " + std::to_string(revision) + ")";
+    }
+    nlohmann::json post = {
+            {"id", id},
+            {"title", title},
+            {"published", "2024-01-01T00:00:00"},
+            {"author_id", (id % config_.authors) + 1},
+    };
+    if (with_content) {
+        // 中英文混合的正文，长度约为 content_bytes
+        std::string content = "# 第" + std::to_string(id) + "篇文章\n\n";
+        if (revision > 0) {
+            content += "第" + std::to_string(revision) + "次修改\n\n";
+        }
+        static const char* words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "性能", "测试", "\t缩进", "终端"};
+        size_t w = id;
+        while (content.size() < config_.content_bytes) {
+            content += words[w++ % 9];
+            content += (w % 12 == 0) ? "\n" : " ";
+        }
+        post["content"] = content;
+    }
+    return post.dump();
+}
+
+void MockBlogServer::count(const std::string& endpoint) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.requests[endpoint];
+}
+
+void MockBlogServer::draw_faults(bool& slow, bool& fail) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    slow = config_.slow_rate > 0 && uniform(random_) < config_.slow_rate;
+    fail = config_.error_rate > 0 && uniform(random_) < config_.error_rate;
+    stats_.injected_delays += slow;
+    stats_.injected_errors += fail;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 模拟博客后端的配置
+struct MockConfig {
+    int posts = 10000;              // 文章总数
+    int authors = 500;              // 作者数
+    int rtt_ms = 20;                // 每个请求在响应前等待的时间，模拟网络往返
+    size_t content_bytes = 2000;    // 每篇文章正文的大约字节数
+    bool content_in_list = true;    // /posts 列表中是否附带正文
+    bool feed = true;               // 是否提供 /feed 长轮询接口
+    int token_ttl_seconds = 0;      // 大于 0 时 /login 返回带 iat 和 exp 的 JWT，否则返回不透明的令牌
+    // 故障注入（/feed 除外），用于验证客户端的超时、重试和对冲请求
+    double error_rate = 0;          // 直接返回 503 的请求比例
+    double slow_rate = 0;           // 额外等待 slow_ms 的请求比例，模拟长尾延迟
+    int slow_ms = 1000;
+};
+
+// 每个端点收到的请求数
+struct MockStats {
+    std::map<std::string, uint64_t> requests;
+    uint64_t connections = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t injected_errors = 0;
+    uint64_t injected_delays = 0;
+};
+
+// 在回环地址上运行的模拟博客后端，支持 keep-alive 和 ETag，提供
+//   GET  /posts?skip=&limit=   GET /posts/{id}   GET /users/{id}
+//   GET  /feed?since=&timeout=（长轮询）
+//   POST /login                POST /posts
+class MockBlogServer {
+public:
+    explicit MockBlogServer(MockConfig config);
+    ~MockBlogServer();
+
+    MockBlogServer(const MockBlogServer&) = delete;
+    MockBlogServer& operator=(const MockBlogServer&) = delete;
+
+    // 监听 127.0.0.1 上的随机端口，失败时返回 false
+    bool start();
+    void stop();
+
+    int port() const { return port_; }
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(port_); }
+
+    MockStats stats() const;
+    uint64_t request_count(const std::string& endpoint) const;
+
+    // 新增一篇文章，使列表的 ETag 失效，并唤醒等待中的 /feed 请求
+    void add_post();
+    // 修改一篇文章的标题和正文
+    void edit_post(int id);
+
+private:
+    struct Response {
+        int status;
+        std::string body;
+        std::string etag;
+    };
+
+    void accept_loop();
+    void serve_connection(int fd);
+    Response route(const std::string& method, const std::string& target, const std::string& if_none_match,
+                   const std::string& idempotency_key);
+    Response feed(const std::string& target);
+    void record_change_locked(int id);
+    std::string post_json(int id, bool with_content) const;
+    void count(const std::string& endpoint);
+    // 按配置的比例决定这个请求是否变慢、是否失败
+    void draw_faults(bool& slow, bool& fail);
+
+    MockConfig config_;
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> running_{false};
+    std::thread accept_thread_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::thread> connection_threads_;
+    std::vector<int> connection_fds_;
+    MockStats stats_;
+    int post_count_;
+    uint64_t version_ = 1;  // 列表每次变化时递增，作为 ETag 和 /feed 的游标
+    std::vector<std::pair<uint64_t, int>> changes_;  // (版本, 文章 id)
+    std::map<int, int> revisions_;                   // 文章 id -> 修改次数
+    std::map<std::string, int> idempotency_keys_;    // POST /posts 的 Idempotency-Key -> 文章 id
+    std::condition_variable changed_;
+    std::mt19937 random_{12345};  // 固定种子，同样的配置注入同样的故障序列
+};
@@ -0,0 +1,155 @@
+// 搜索索引的微基准：生成一批文章建立倒排索引，模拟逐字输入查询（每输入一个字符搜索一次），
+// 测量一个和两个字母的前缀、完整单词和多个词的查询在每次按键上的耗时，每项取多次运行中最快的一次，结果以 JSON 输出
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_index.h"
+
+namespace {
+
+// 线程 CPU 时间，不受其他进程抢占的影响
+double cpu_ms() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+template <typename F>
+double best_of(int iterations, F&& run) {
+    double best = 1e300;
+    for (int i = 0; i < iterations; ++i) {
+        double start = cpu_ms();
+        run();
+        best = std::min(best, cpu_ms() - start);
+    }
+    return best;
+}
+
+// 由音节拼成的英文词表，固定种子，每次运行相同
+std::vector<std::string> make_vocabulary(size_t size) {
+    static const char* syllables[] = {"th", "co", "re", "an", "in", "st", "pro", "de", "ma", "ter",
+                                      "ca", "le", "ti", "on", "ve", "ri", "ne", "se", "al", "ch"};
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> syllable(0, 19), count(1, 4);
+    std::vector<std::string> words;
+    words.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        std::string word;
+        for (int n = count(random); n > 0; --n) {
+            word += syllables[syllable(random)];
+        }
+        words.push_back(word + std::to_string(i % 7));  // 同样的音节组合也成为不同的词
+    }
+    return words;
+}
+
+// 词频大致呈长尾分布：靠前的词出现得多
+std::string make_text(const std::vector<std::string>& vocabulary, size_t words, std::mt19937& random) {
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::string text;
+    for (size_t i = 0; i < words; ++i) {
+        double r = uniform(random);
+        text += vocabulary[static_cast<size_t>(r * r * r * vocabulary.size())];
+        text += i % 12 == 11 ? ".\n" : " ";
+    }
+    return text;
+}
+
+void usage() {
+    std::cerr << "usage: miniBlogTUI_search_bench [--posts N] [--words N] 每篇正文的词数 [--vocabulary N]\n"
+                 "                                [--iterations N] [--output FILE]\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int posts = 10000;
+    size_t words = 200;
+    size_t vocabulary_size = 50000;
+    int iterations = 10;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--posts") posts = std::max(std::atoi(next()), 1);
+        else if (arg == "--words") words = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--vocabulary") vocabulary_size = std::max<size_t>(std::strtoul(next(), nullptr, 10), 1);
+        else if (arg == "--iterations") iterations = std::max(std::atoi(next()), 1);
+        else if (arg == "--output") output = next();
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    std::vector<std::string> vocabulary = make_vocabulary(vocabulary_size);
+    std::mt19937 random(7);
+    std::vector<std::string> titles, contents;
+    for (int i = 0; i < posts; ++i) {
+        titles.push_back(make_text(vocabulary, 6, random));
+        contents.push_back(make_text(vocabulary, words, random));
+    }
+
+    SearchIndex index;
+    double index_ms = best_of(1, [&] {
+        for (int i = 0; i < posts; ++i) {
+            index.index_title(i, titles[i]);
+            index.index_content(i, contents[i]);
+        }
+    });
+
+    // 逐字输入整个查询，每个前缀搜索一次；记录最慢的一次按键和平均值
+    nlohmann::json queries = nlohmann::json::object();
+    auto typing = [&](const std::string& name, const std::string& query) {
+        size_t matches = 0;
+        double slowest = 0;
+        double total = best_of(iterations, [&] {
+            slowest = 0;
+            for (size_t length = 1; length <= query.size(); ++length) {
+                double start = cpu_ms();
+                // 与界面一致：查询还不能过滤时显示完整列表，不搜索
+                std::string_view typed = std::string_view(query).substr(0, length);
+                matches = SearchIndex::filters(typed) ? index.search(typed).size() : static_cast<size_t>(posts);
+                slowest = std::max(slowest, cpu_ms() - start);
+            }
+        });
+        queries[name] = {{"query", query},
+                         {"keystrokes", query.size()},
+                         {"us_per_keystroke", total * 1e3 / query.size()},
+                         {"slowest_keystroke_us", slowest * 1e3},
+                         {"matches", matches}};
+    };
+    typing("one_letter", "t");
+    typing("two_letters", "th");
+    typing("two_letters_common", "co");
+    typing("word", vocabulary[0]);
+    typing("words_with_prefix", vocabulary[0] + " " + vocabulary[1].substr(0, 2));
+
+    nlohmann::json result = {
+            {"config", {{"posts", posts}, {"words", words}, {"vocabulary", vocabulary_size}, {"iterations", iterations}}},
+            {"index", {{"ms", index_ms}}},
+            {"queries", queries},
+    };
+
+    std::string text = result.dump(2);
+    if (output.empty()) {
+        std::cout << text << std::endl;
+    } else {
+        std::ofstream(output) << text << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,292 @@
+#include "auth_session.h"
+
+#include <cpr/cpr.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <fstream>
+
+#include "http_client.h"
+
+namespace {
+
+const std::chrono::seconds MIN_RETRY(5);
+const std::chrono::seconds MAX_RETRY(300);
+const std::chrono::seconds MIN_REFRESH_INTERVAL(5);  // 两次成功刷新之间至少间隔的时间
+
+// base64url 解码（无填充），遇到非法字符时返回 false
+bool decode_base64url(const std::string& in, std::string& out) {
+    out.clear();
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : in) {
+        int value;
+        if (c >= 'A' && c <= 'Z') value = c - 'A';
+        else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') value = c - '0' + 52;
+        else if (c == '-' || c == '+') value = 62;
+        else if (c == '_' || c == '/') value = 63;
+        else if (c == '=') break;
+        else return false;
+        bits = (bits << 6) | value;
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            out.push_back(static_cast<char>((bits >> count) & 0xFF));
+        }
+    }
+    return true;
+}
+
+// POST /login，成功时返回 access_token，失败时把原因写入 error
+bool request_token(const std::string& username, const std::string& password, std::string& token, std::string& error) {
+    try {
+        cpr::Response response = http_client().post(
+                "/login", {},
+                cpr::Payload{{"username", username}, {"password", password}}
+        );
+        if (response.status_code != 200) {
+            error = "Failed to login, status code: " + std::to_string(response.status_code);
+            return false;
+        }
+        auto resp_json = nlohmann::json::parse(response.text);
+        if (!resp_json.contains("access_token")) {
+            error = "Login successful but no access token provided.";
+            return false;
+        }
+        token = resp_json["access_token"].get<std::string>();
+        if (token.empty()) {
+            error = "Login returned an empty access token.";
+            return false;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        error = std::string("Exception occurred: ") + e.what();
+        return false;
+    }
+}
+
+}  // namespace
+
+bool jwt_expiry(const std::string& token, int64_t& expires_at, int64_t* issued_at) {
+    size_t first = token.find('.');
+    size_t second = first == std::string::npos ? first : token.find('.', first + 1);
+    if (second == std::string::npos) {
+        return false;
+    }
+    std::string payload;
+    if (!decode_base64url(token.substr(first + 1, second - first - 1), payload)) {
+        return false;
+    }
+    auto claims = nlohmann::json::parse(payload, nullptr, false);
+    if (!claims.is_object() || !claims.contains("exp") || !claims["exp"].is_number()) {
+        return false;
+    }
+    expires_at = claims["exp"].get<int64_t>();
+    if (issued_at) {
+        *issued_at = claims.contains("iat") && claims["iat"].is_number() ? claims["iat"].get<int64_t>() : 0;
+    }
+    return true;
+}
+
+std::chrono::seconds refresh_lead(std::chrono::seconds lifetime, std::chrono::seconds margin) {
+    return std::clamp(lifetime / 2, std::chrono::seconds(0), margin);
+}
+
+AuthSession::AuthSession(std::string path, std::chrono::seconds refresh_margin)
+        : path_(std::move(path)), refresh_margin_(refresh_margin) {}
+
+AuthSession::~AuthSession() {
+    stop();
+}
+
+bool AuthSession::load() {
+    std::ifstream token_file(path_);
+    std::string token;
+    if (!token_file.is_open() || !std::getline(token_file, token) || token.empty()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    install_locked(token);
+    if (expired_locked(Clock::now())) {
+        clear_locked();  // 上次保存的令牌已过期，需要重新登录
+        return false;
+    }
+    return true;
+}
+
+void AuthSession::start() {
+    if (!thread_.joinable()) {
+        stopping_ = false;
+        thread_ = std::thread(&AuthSession::run, this);
+    }
+}
+
+void AuthSession::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool AuthSession::login(const std::string& username, const std::string& password) {
+    std::string token, error;
+    if (!request_token(username, password, token, error)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = error;
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_.clear();
+        username_ = username;
+        password_ = password;
+        failures_ = 0;
+        retry_after_ = Clock::time_point();
+        install_locked(token);
+    }
+    if (!save(token)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = "Failed to open token file for writing.";
+    }
+    return true;
+}
+
+std::string AuthSession::last_error() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+bool AuthSession::logged_in() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !token_.empty() && !expired_locked(Clock::now());
+}
+
+std::string AuthSession::token() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (needs_refresh_locked(Clock::now())) {
+        refresh(lock);
+    }
+    // 刷新失败但令牌还没过期时继续使用旧令牌
+    return expired_locked(Clock::now()) ? std::string() : token_;
+}
+
+void AuthSession::reject(const std::string& token) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (token.empty() || token != token_) {
+        return;  // 令牌已经换过，不必再刷新
+    }
+    if (username_.empty()) {
+        clear_locked();  // 从文件读取的令牌无法刷新，需要重新登录
+    } else {
+        expires_at_ = Clock::now();
+        refresh_at_ = expires_at_;
+        cv_.notify_all();
+    }
+}
+
+void AuthSession::install_locked(const std::string& token) {
+    token_ = token;
+    int64_t exp, iat;
+    if (jwt_expiry(token, exp, &iat)) {
+        expires_at_ = Clock::time_point(std::chrono::seconds(exp));
+        // 没有 iat 时按现在签发计算有效期
+        Clock::time_point issued = iat > 0 ? Clock::time_point(std::chrono::seconds(iat)) : Clock::now();
+        auto lifetime = std::chrono::duration_cast<std::chrono::seconds>(expires_at_ - issued);
+        refresh_at_ = expires_at_ - refresh_lead(lifetime, refresh_margin_);
+    } else {
+        expires_at_ = Clock::time_point::max();
+        refresh_at_ = Clock::time_point::max();
+    }
+    http_client().set_bearer_token(token);  // 之后的请求自动带上令牌
+    cv_.notify_all();  // 后台线程按新的过期时间重新安排刷新
+}
+
+void AuthSession::clear_locked() {
+    token_.clear();
+    expires_at_ = Clock::time_point::max();
+    refresh_at_ = Clock::time_point::max();
+    http_client().clear_bearer_token();
+}
+
+bool AuthSession::expired_locked(Clock::time_point now) const {
+    return !token_.empty() && expires_at_ != Clock::time_point::max() && now >= expires_at_;
+}
+
+bool AuthSession::needs_refresh_locked(Clock::time_point now) const {
+    return !token_.empty() && refresh_at_ != Clock::time_point::max() && now >= refresh_at_;
+}
+
+bool AuthSession::refresh(std::unique_lock<std::mutex>& lock) {
+    if (refreshing_) {
+        cv_.wait(lock, [this] { return !refreshing_ || stopping_; });
+        return !needs_refresh_locked(Clock::now());
+    }
+    if (username_.empty() || Clock::now() < retry_after_) {
+        return false;
+    }
+
+    refreshing_ = true;
+    std::string username = username_, password = password_;
+    lock.unlock();
+    std::string token, error;
+    bool ok = request_token(username, password, token, error);
+    if (ok && !save(token)) {
+        error = "Failed to open token file for writing.";  // 令牌仍然可用，只是下次启动要重新登录
+    }
+    lock.lock();
+    refreshing_ = false;
+    last_error_ = error;
+
+    if (ok) {
+        failures_ = 0;
+        retry_after_ = Clock::now() + MIN_REFRESH_INTERVAL;  // 服务器签发的令牌有效期很短时也不会连续登录
+        install_locked(token);
+    } else {
+        ++failures_;
+        retry_after_ = Clock::now() + std::min(MAX_RETRY, MIN_RETRY * (1 << std::min(failures_ - 1, 6)));
+        if (expired_locked(Clock::now())) {
+            clear_locked();
+        }
+    }
+    cv_.notify_all();
+    return ok;
+}
+
+bool AuthSession::save(const std::string& token) {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    std::ofstream token_file(path_, std::ios::trunc);
+    if (!token_file.is_open()) {
+        return false;
+    }
+    token_file << token;
+    return true;
+}
+
+// 在 refresh_at_ 刷新令牌；没有过期时间或无法刷新时等待新的登录
+void AuthSession::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        Clock::time_point wake = Clock::time_point::max();
+        if (!token_.empty() && !username_.empty() && refresh_at_ != Clock::time_point::max()) {
+            wake = std::max(refresh_at_, retry_after_);
+        }
+        if (Clock::now() >= wake) {
+            refresh(lock);
+            continue;
+        }
+        if (wake == Clock::time_point::max()) {
+            cv_.wait(lock);
+        } else {
+            cv_.wait_until(lock, wake);
+        }
+    }
+}
+
+AuthSession& auth_session() {
+    static AuthSession session;
+    return session;
+}
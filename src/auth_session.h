@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// 登录令牌文件，放在当前目录
+const std::string TOKEN_FILE = "token";
+
+// 在本地解码 JWT 的载荷，取出 exp（Unix 秒）；不是 JWT 或没有 exp 时返回 false。
+// issued_at 不为空时写入 iat，没有 iat 时写入 0
+bool jwt_expiry(const std::string& token, int64_t& expires_at, int64_t* issued_at = nullptr);
+
+// 在过期前多久刷新：通常为 margin，但不超过有效期的一半，
+// 否则有效期不超过 margin 的令牌刚拿到就需要刷新，后台线程会连续登录
+std::chrono::seconds refresh_lead(std::chrono::seconds lifetime, std::chrono::seconds margin);
+
+// 登录会话：令牌只在启动时从文件读取一次，之后保存在内存中，并设置为 http_client 的默认 Bearer 令牌。
+// 令牌是带 exp 的 JWT 时，后台线程在过期前用本次登录的用户名和密码重新登录；
+// 多个线程同时需要刷新时只有一个发出请求，其余等待它的结果，失败后退避，不会反复登录。
+// 令牌文件只在登录成功后由发起登录的后台线程写入，UI 线程只读取内存中的状态
+class AuthSession {
+public:
+    explicit AuthSession(std::string path = TOKEN_FILE, std::chrono::seconds refresh_margin = std::chrono::seconds(60));
+    ~AuthSession();
+
+    AuthSession(const AuthSession&) = delete;
+    AuthSession& operator=(const AuthSession&) = delete;
+
+    // 读取令牌文件，文件不存在或令牌已过期时返回 false
+    bool load();
+
+    // 启动后台刷新线程，重复调用无效
+    void start();
+    void stop();
+
+    // 用户名和密码登录，成功后保存令牌；会阻塞，只能在后台线程调用
+    bool login(const std::string& username, const std::string& password);
+
+    // 有未过期的令牌；只读内存，可以在 UI 线程调用
+    bool logged_in() const;
+
+    // 最近一次登录或刷新失败的原因，成功后清空；可以在 UI 线程调用，由界面显示在状态栏
+    std::string last_error() const;
+
+    // 返回可用的令牌，即将过期时先刷新（可能阻塞，只能在后台线程调用）；没有可用令牌时返回空字符串
+    std::string token();
+
+    // 服务器以 401 拒绝了 token：如果它仍是当前令牌，标记为过期，下一次 token() 重新登录
+    void reject(const std::string& token);
+
+private:
+    using Clock = std::chrono::system_clock;
+
+    void install_locked(const std::string& token);
+    void clear_locked();
+    bool expired_locked(Clock::time_point now) const;
+    bool needs_refresh_locked(Clock::time_point now) const;
+    // 用保存的用户名和密码重新登录；已有线程在刷新时等待其结果
+    bool refresh(std::unique_lock<std::mutex>& lock);
+    bool save(const std::string& token);
+    void run();
+
+    std::string path_;
+    std::chrono::seconds refresh_margin_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::string token_;
+    Clock::time_point expires_at_ = Clock::time_point::max();  // 不是 JWT 时视为不过期
+    Clock::time_point refresh_at_ = Clock::time_point::max();  // 过期前 refresh_lead 的时刻
+    std::string username_;
+    std::string password_;
+    bool refreshing_ = false;
+    int failures_ = 0;                   // 连续刷新失败的次数
+    Clock::time_point retry_after_;      // 刷新失败或成功后，在此之前不再刷新
+    std::string last_error_;
+
+    std::mutex file_mutex_;  // 保证令牌文件按登录顺序写入
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+};
+
+// 全局登录会话
+AuthSession& auth_session();
@@ -0,0 +1,125 @@
+#include "author_directory.h"
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "http_client.h"
+#include "trace.h"
+
+const std::string UNKNOWN_AUTHOR = "Unknown Author";
+
+bool fetch_author_name(int author_id, std::string& name) {
+    TRACE_SCOPE("fetch_author");
+    auto response = http_client().get("/users/" + std::to_string(author_id), {});
+
+    if (response.status_code != 200) {
+        return false;  // 请求失败或找不到用户
+    }
+
+    try {
+        TRACE_SCOPE("json_parse");
+        auto json_response = nlohmann::json::parse(response.text);
+        name = json_response["username"].get<std::string>();
+        return true;
+    } catch (const std::exception& e) {
+        return false;  // 响应格式不正确
+    }
+}
+
+AuthorDirectory::AuthorDirectory(size_t capacity, size_t max_concurrency)
+    : capacity_(std::max<size_t>(capacity, 1)), max_concurrency_(std::max<size_t>(max_concurrency, 1)) {}
+
+std::unordered_map<int, std::string> AuthorDirectory::resolve(const std::vector<int>& author_ids) {
+    std::unordered_map<int, std::string> names;
+    std::vector<int> missing;
+
+    // 去重，并先从缓存中取已知的作者
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int id : author_ids) {
+            if (names.count(id)) continue;
+            std::string name;
+            if (lookup_locked(id, name)) {
+                TRACE_COUNT("author_cache.hit");
+                names.emplace(id, std::move(name));
+            } else {
+                TRACE_COUNT("author_cache.miss");
+                names.emplace(id, UNKNOWN_AUTHOR);
+                missing.push_back(id);
+            }
+        }
+    }
+
+    if (missing.empty()) {
+        return names;
+    }
+
+    // 并发请求缺失的作者，工作线程数量有上限
+    std::vector<std::string> fetched(missing.size());
+    std::vector<char> ok(missing.size(), 0);
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < missing.size(); i = next++) {
+            ok[i] = fetch_author_name(missing[i], fetched[i]);
+        }
+    };
+
+    size_t thread_count = std::min(max_concurrency_, missing.size());
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+    for (size_t t = 1; t < thread_count; ++t) {
+        workers.emplace_back(worker);
+    }
+    worker();  // 当前线程也参与
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    // 只缓存成功的结果，失败的下次刷新时重试
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (ok[i]) {
+            insert_locked(missing[i], fetched[i]);
+            names[missing[i]] = std::move(fetched[i]);
+        }
+    }
+    return names;
+}
+
+void AuthorDirectory::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    entries_.clear();
+}
+
+bool AuthorDirectory::lookup_locked(int author_id, std::string& name) {
+    auto it = entries_.find(author_id);
+    if (it == entries_.end()) {
+        return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);  // 移到最前
+    name = it->second->second;
+    return true;
+}
+
+void AuthorDirectory::insert_locked(int author_id, const std::string& name) {
+    auto it = entries_.find(author_id);
+    if (it != entries_.end()) {
+        it->second->second = name;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+    lru_.emplace_front(author_id, name);
+    entries_[author_id] = lru_.begin();
+    if (lru_.size() > capacity_) {
+        entries_.erase(lru_.back().first);  // 淘汰最久未使用的
+        lru_.pop_back();
+    }
+}
+
+AuthorDirectory& author_directory() {
+    static AuthorDirectory directory;
+    return directory;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 请求单个作者的用户名，成功时写入 name 并返回 true
+bool fetch_author_name(int author_id, std::string& name);
+
+// 作者目录：批量解析 author_id -> 用户名
+// 同一批次内去重，只请求缓存中没有的 id，并用有限个工作线程并发请求；
+// 结果保存在 LRU 缓存中，F5 刷新时直接复用
+class AuthorDirectory {
+public:
+    explicit AuthorDirectory(size_t capacity = 1024, size_t max_concurrency = 8);
+
+    // 解析一批作者 id，返回每个不同 id 对应的用户名（失败的为 "Unknown Author"）
+    std::unordered_map<int, std::string> resolve(const std::vector<int>& author_ids);
+
+    // 清空缓存
+    void clear();
+
+private:
+    bool lookup_locked(int author_id, std::string& name);
+    void insert_locked(int author_id, const std::string& name);
+
+    size_t capacity_;
+    size_t max_concurrency_;
+    std::mutex mutex_;
+    std::list<std::pair<int, std::string>> lru_;  // 最近使用的在前
+    std::unordered_map<int, std::list<std::pair<int, std::string>>::iterator> entries_;
+};
+
+// 全局作者目录，生命周期与程序相同
+AuthorDirectory& author_directory();
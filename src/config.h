@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdlib>
+#include <string>
+
+// 后端服务地址，可以用环境变量 MINIBLOG_URL 覆盖（例如指向基准测试的模拟服务器）
+inline const std::string URL = std::getenv("MINIBLOG_URL") ? std::getenv("MINIBLOG_URL") : "http://127.0.0.1:8000";
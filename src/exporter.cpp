@@ -0,0 +1,349 @@
+#include "exporter.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "post_source.h"
+
+namespace {
+
+const int MAX_ATTEMPTS = 3;                   // 每页和每篇正文最多请求的次数
+const size_t JSONL_BUFFER_BYTES = 1 << 20;   // jsonl 攒够这么多再写入
+const std::string MANIFEST_HEADER = "miniblog-export 1 ";
+
+// 一页请求的结果
+struct Page {
+    int index;
+    std::vector<Post> posts;
+};
+
+// 有上限的队列：满时请求线程等待写文件的线程，关闭后取完剩余的页即结束
+class PageQueue {
+public:
+    explicit PageQueue(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+    void push(Page page) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return pages_.size() < capacity_; });
+        pages_.push_back(std::move(page));
+        not_empty_.notify_one();
+    }
+
+    bool pop(Page& page) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return !pages_.empty() || closed_; });
+        if (pages_.empty()) {
+            return false;
+        }
+        page = std::move(pages_.front());
+        pages_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+private:
+    size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<Page> pages_;
+    bool closed_ = false;
+};
+
+// 文章内容的 64 位 FNV-1a 摘要，用于判断文章是否变化
+uint64_t post_digest(const Post& post) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const std::string* field : {&post.title, &post.author_name, &post.published, &post.content}) {
+        for (unsigned char c : *field) {
+            hash = (hash ^ c) * 1099511628211ull;
+        }
+        hash = (hash ^ 0xFF) * 1099511628211ull;  // 字段之间的分隔，"ab"+"c" 与 "a"+"bc" 不同
+    }
+    return hash;
+}
+
+const char* format_name(ExportFormat format) {
+    return format == ExportFormat::MARKDOWN ? "md" : "jsonl";
+}
+
+// 读取上次导出的记录；格式不同或文件不存在时返回 false，按全新导出处理
+bool load_manifest(const std::string& path, ExportFormat format, std::unordered_map<int, uint64_t>& digests) {
+    std::ifstream in(path);
+    std::string header;
+    if (!std::getline(in, header) || header != MANIFEST_HEADER + format_name(format)) {
+        return false;
+    }
+    int id;
+    uint64_t digest;
+    while (in >> id >> std::hex >> digest >> std::dec) {
+        digests[id] = digest;
+    }
+    return true;
+}
+
+// 先写临时文件再改名，中途失败时上次的记录仍然完整
+bool save_manifest(const std::string& path, ExportFormat format, const std::unordered_map<int, uint64_t>& digests) {
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        out << MANIFEST_HEADER << format_name(format) << '\n' << std::hex;
+        for (const auto& [id, digest] : digests) {
+            out << std::dec << id << ' ' << std::hex << digest << '\n';
+        }
+        if (!out.flush()) {
+            return false;
+        }
+    }
+    return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+bool write_all(int fd, iovec* parts, int count) {
+    int index = 0;
+    while (index < count) {
+        ssize_t n = writev(fd, parts + index, count - index);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        while (index < count && (n > 0 || parts[index].iov_len == 0)) {  // 同时跳过空的部分
+            size_t used = std::min(static_cast<size_t>(n), parts[index].iov_len);
+            parts[index].iov_base = static_cast<char*>(parts[index].iov_base) + used;
+            parts[index].iov_len -= used;
+            n -= used;
+            if (parts[index].iov_len == 0) ++index;
+        }
+    }
+    return true;
+}
+
+std::string markdown_path(const std::string& dir, int post_id) {
+    return dir + "/" + std::to_string(post_id) + ".md";
+}
+
+// 写入 <id>.md：头信息和正文用一次 writev 写入临时文件，不复制正文，再改名替换旧文件
+bool write_markdown(const std::string& dir, const Post& post) {
+    std::string header = "---\nid: " + std::to_string(post.id) + "\ntitle: " + nlohmann::json(post.title).dump() +
+                         "\nauthor: " + nlohmann::json(post.author_name).dump() +
+                         "\npublished: " + nlohmann::json(post.published).dump() + "\n---\n\n";
+    std::string path = markdown_path(dir, post.id);
+    std::string tmp_path = path + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    iovec parts[2] = {{header.data(), header.size()}, {const_cast<char*>(post.content.data()), post.content.size()}};
+    bool ok = write_all(fd, parts, 2);
+    ok = close(fd) == 0 && ok;
+    if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void append_json_line(const Post& post, std::string& buffer) {
+    nlohmann::json line = {{"id", post.id},
+                           {"title", post.title},
+                           {"author_id", post.author_id},
+                           {"author", post.author_name},
+                           {"published", post.published},
+                           {"content", post.content}};
+    buffer += line.dump();
+    buffer += '\n';
+}
+
+}  // namespace
+
+bool export_posts(const ExportOptions& options, ExportStats& stats) {
+    if (mkdir(options.dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Failed to create " << options.dir << "\n";
+        return false;
+    }
+    std::string manifest_path = options.dir + "/" + EXPORT_MANIFEST_FILE;
+    std::unordered_map<int, uint64_t> previous;
+    bool incremental = !options.full && load_manifest(manifest_path, options.format, previous);
+
+    // jsonl：全新导出时重写，增量导出时追加
+    int jsonl_fd = -1;
+    if (options.format == ExportFormat::JSONL) {
+        std::string path = options.dir + "/posts.jsonl";
+        jsonl_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (incremental ? O_APPEND : O_TRUNC), 0644);
+        if (jsonl_fd < 0) {
+            std::cerr << "Failed to open " << path << "\n";
+            return false;
+        }
+    }
+
+    PageQueue queue(2 * options.concurrency);
+    std::atomic<int> next_page{0};
+    std::atomic<int> last_page{INT_MAX};  // 第一个不满的页，之后的页不必再请求
+    std::atomic<bool> fetch_failed{false};  // 有页取不到，停止导出
+    std::atomic<size_t> skipped{0};         // 取不到正文、这次没有导出的文章
+
+    auto fetch_pages = [&]() {
+        for (int index = next_page++; index <= last_page && !fetch_failed; index = next_page++) {
+            std::vector<Post> posts;
+            std::string error;
+            bool ok = false;
+            for (int attempt = 0; attempt < MAX_ATTEMPTS && !ok; ++attempt) {
+                if (attempt > 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(200 << attempt));
+                }
+                ok = fetch_and_parse_posts(index * options.page_size, options.page_size, posts, nullptr, &error);
+            }
+            if (!ok) {
+                std::cerr << error << " (offset " << index * options.page_size << ")\n";
+                fetch_failed = true;
+                break;
+            }
+            if (static_cast<int>(posts.size()) < options.page_size) {
+                int expected = last_page;
+                while (index < expected && !last_page.compare_exchange_weak(expected, index)) {
+                }
+            }
+            // 列表不附带正文时逐篇获取，与页一样重试；仍然失败的文章这次不导出，其余的照常导出
+            auto missing = std::remove_if(posts.begin(), posts.end(), [&](Post& post) {
+                if (!post.content.empty()) {
+                    return false;
+                }
+                std::string error;
+                for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+                    if (attempt > 0) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(200 << attempt));
+                    }
+                    if (fetch_post_content(post.id, post.content, &error)) {
+                        return false;
+                    }
+                }
+                std::cerr << "Failed to fetch content of post " << post.id << ": " << error << "\n";
+                ++skipped;
+                return true;
+            });
+            posts.erase(missing, posts.end());
+            queue.push({index, std::move(posts)});
+        }
+    };
+
+    // 写文件在单独的线程中进行，与请求同时进行
+    std::unordered_map<int, uint64_t> current;  // 本次导出的每篇文章的摘要
+    bool write_failed = false;
+    std::thread writer([&]() {
+        std::string buffer;
+        auto flush = [&]() {
+            iovec part{buffer.data(), buffer.size()};
+            if (!buffer.empty() && !write_all(jsonl_fd, &part, 1)) {
+                write_failed = true;
+            }
+            buffer.clear();
+        };
+        auto write_post = [&](const Post& post) {
+            uint64_t digest = post_digest(post);
+            if (!current.emplace(post.id, digest).second) {
+                return;  // 导出期间有新文章时，分页移动，同一篇可能出现在两页中
+            }
+            auto it = previous.find(post.id);
+            if (incremental && it != previous.end() && it->second == digest &&
+                (jsonl_fd >= 0 || access(markdown_path(options.dir, post.id).c_str(), F_OK) == 0)) {
+                ++stats.unchanged;
+                return;
+            }
+            if (jsonl_fd >= 0) {
+                append_json_line(post, buffer);
+                if (buffer.size() >= JSONL_BUFFER_BYTES) flush();
+            } else if (!write_markdown(options.dir, post)) {
+                std::cerr << "Failed to write " << markdown_path(options.dir, post.id) << "\n";
+                current.erase(post.id);
+                write_failed = true;
+                return;
+            }
+            ++stats.written;
+        };
+
+        // md 按到达的顺序写入；jsonl 按页的顺序写入，文件中的顺序与服务器一致
+        std::map<int, std::vector<Post>> pending;
+        int next_write = 0;
+        Page page;
+        while (queue.pop(page)) {
+            if (jsonl_fd < 0) {
+                for (const Post& post : page.posts) write_post(post);
+                continue;
+            }
+            pending.emplace(page.index, std::move(page.posts));
+            for (auto it = pending.begin(); it != pending.end() && it->first == next_write; it = pending.erase(it)) {
+                for (const Post& post : it->second) write_post(post);
+                ++next_write;
+            }
+        }
+        for (const auto& [index, posts] : pending) {
+            for (const Post& post : posts) write_post(post);  // 中间有页失败时，其后的页也写入
+        }
+        flush();
+    });
+
+    std::vector<std::thread> fetchers;
+    for (int i = 0; i < std::max(options.concurrency, 1); ++i) {
+        fetchers.emplace_back(fetch_pages);
+    }
+    for (auto& fetcher : fetchers) {
+        fetcher.join();
+    }
+    queue.close();
+    writer.join();
+
+    stats.skipped = skipped;
+    bool ok = !fetch_failed && skipped == 0 && !write_failed;
+    if (ok && incremental) {
+        // 完整地取到了所有文章，上次有而这次没有的文章已被删除
+        std::string tombstones;
+        for (const auto& [id, digest] : previous) {
+            if (current.count(id)) {
+                continue;
+            }
+            if (jsonl_fd >= 0) {
+                tombstones += "{\"id\":" + std::to_string(id) + ",\"deleted\":true}\n";
+            } else {
+                unlink(markdown_path(options.dir, id).c_str());
+            }
+            ++stats.deleted;
+        }
+        iovec part{tombstones.data(), tombstones.size()};
+        if (!tombstones.empty() && !write_all(jsonl_fd, &part, 1)) {
+            ok = false;
+        }
+    } else if (!ok) {
+        // 没有取全时不知道哪些文章被删除，保留上次的记录；跳过的文章下次按上次的摘要比较，有变化时再写入
+        for (const auto& [id, digest] : previous) current.emplace(id, digest);
+    }
+    if (jsonl_fd >= 0 && close(jsonl_fd) != 0) {
+        ok = false;
+    }
+    if (!save_manifest(manifest_path, options.format, current)) {
+        std::cerr << "Failed to write " << manifest_path << "\n";
+        ok = false;
+    }
+    return ok;
+}
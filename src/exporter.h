@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// 导出的文件格式
+enum class ExportFormat {
+    MARKDOWN,  // 每篇文章一个 <id>.md，开头是 YAML 头信息
+    JSONL,     // 所有文章追加到 posts.jsonl，每行一个 JSON 对象
+};
+
+struct ExportOptions {
+    std::string dir;
+    ExportFormat format = ExportFormat::MARKDOWN;
+    int concurrency = 4;   // 同时请求的页数
+    int page_size = 100;
+    bool full = false;     // 忽略上次导出的记录，全部重写
+};
+
+struct ExportStats {
+    size_t written = 0;    // 新增或修改后写入的文章
+    size_t unchanged = 0;  // 与上次导出相同而跳过的文章
+    size_t deleted = 0;    // 服务器上已删除、从导出中移除的文章
+    size_t skipped = 0;    // 取不到正文、这次没有导出的文章
+};
+
+// 无界面的批量导出，供 cron 等定时任务归档或镜像博客。
+// concurrency 个线程并发请求各页（作者名和缺少的正文也在这些线程中获取），
+// 结果经有界队列交给写文件的线程，请求和写文件同时进行。
+// 目录中的 .export-manifest 记录每篇文章上次导出时的摘要，再次导出时只写入有变化的文章：
+// md 格式只重写变化的文件并删除已删除文章的文件；jsonl 格式只追加变化的行，
+// 已删除的文章追加 {"id": N, "deleted": true}，读取时同一 id 以最后一行为准。
+// 取不到正文的文章跳过，其余文章照常导出，但这次不判断哪些文章已删除。
+// 所有页和所有文章都成功时返回 true
+bool export_posts(const ExportOptions& options, ExportStats& stats);
+
+// 导出记录的文件名，放在导出目录中
+const std::string EXPORT_MANIFEST_FILE = ".export-manifest";
@@ -0,0 +1,251 @@
+#include "http_client.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <thread>
+
+#include "config.h"
+#include "trace.h"
+
+namespace {
+
+// 可以重试的失败：连接失败或超时（status_code 为 0）、限流和服务器错误
+bool should_retry(const cpr::Response& response) {
+    return response.status_code == 0 || response.status_code == 429 || response.status_code >= 500;
+}
+
+// 429 和 503 响应中 Retry-After 要求的等待（只支持秒数），最多 10 秒
+std::chrono::milliseconds retry_after(const cpr::Response& response) {
+    auto it = response.header.find("Retry-After");
+    if ((response.status_code != 429 && response.status_code != 503) || it == response.header.end()) {
+        return std::chrono::milliseconds(0);
+    }
+    long seconds = std::strtol(it->second.c_str(), nullptr, 10);
+    return std::chrono::seconds(std::clamp(seconds, 0L, 10L));
+}
+
+std::chrono::milliseconds elapsed_ms(const cpr::Response& response) {
+    return std::chrono::milliseconds(static_cast<int64_t>(response.elapsed * 1000));
+}
+
+}  // namespace
+
+// 对冲请求的两个参与者共享的状态。先完成且不需要重试的响应胜出，
+// 之后另一个请求由进度回调中止；两个都失败时取后完成的
+struct HttpClient::HedgeRace {
+    std::mutex mutex;
+    std::condition_variable decided_changed;
+    int running = 0;
+    bool decided = false;
+    bool hedge_won = false;
+    cpr::Response response;
+    std::atomic<bool> cancelled{false};
+};
+
+HttpClient::HttpClient(std::string base_url) : base_url_(std::move(base_url)), share_(curl_share_init()) {
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &HttpClient::lock_share);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &HttpClient::unlock_share);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);      // 连接池
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);          // DNS 缓存
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);  // TLS 会话恢复
+}
+
+HttpClient::~HttpClient() {
+    closing_ = true;  // 进度回调返回 false，进行中的请求很快中止
+    std::unique_lock<std::mutex> lock(racers_mutex_);
+    racers_done_.wait(lock, [this] { return racers_ == 0; });
+    lock.unlock();
+    curl_share_cleanup(share_);
+}
+
+void HttpClient::set_bearer_token(const std::string& token) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bearer_token_ = token;
+}
+
+void HttpClient::clear_bearer_token() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bearer_token_.clear();
+}
+
+void HttpClient::set_timeouts(std::chrono::milliseconds connect_timeout, std::chrono::milliseconds total_timeout) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connect_timeout_ = connect_timeout;
+    total_timeout_ = total_timeout;
+}
+
+bool HttpClient::set_timing_log(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timing_log_.open(path, std::ios::app);
+    return timing_log_.is_open();
+}
+
+HttpStats HttpClient::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+cpr::Response HttpClient::execute(const char* method, const std::string& path, const cpr::Header& header, bool replayable,
+                                  const ApplyOptions& apply) {
+    EndpointState& endpoint = scheduler_.endpoint(method, path);
+    RequestPolicy policy = endpoint.policy();
+    int attempts = replayable ? std::max(policy.max_attempts, 1) : 1;
+    for (int attempt = 1;; ++attempt) {
+        cpr::Response response = replayable && policy.hedge ? perform_hedged(endpoint, policy, path, header, apply)
+                                                            : perform(endpoint, policy, method, path, header, apply);
+        if (attempt >= attempts || !should_retry(response)) {
+            return response;
+        }
+        TRACE_COUNT("http.retry");
+        std::this_thread::sleep_for(std::max(RequestScheduler::backoff(policy, attempt), retry_after(response)));
+    }
+}
+
+cpr::Response HttpClient::perform(EndpointState& endpoint, const RequestPolicy& policy, const char* method,
+                                  const std::string& path, const cpr::Header& header, const ApplyOptions& apply) {
+    endpoint.acquire();
+    RequestSlot slot(&endpoint);
+    cpr::Session session;
+    prepare(session, path, header, policy.timeout);
+    apply(session);
+    cpr::Response response = std::strcmp(method, "POST") == 0 ? session.Post() : session.Get();
+    slot.release();
+    if (!should_retry(response)) {
+        endpoint.record_latency(elapsed_ms(response));
+    }
+    return finish(session, method, path, std::move(response));
+}
+
+cpr::Response HttpClient::perform_hedged(EndpointState& endpoint, const RequestPolicy& policy, const std::string& path,
+                                         const cpr::Header& header, const ApplyOptions& apply) {
+    auto race = std::make_shared<HedgeRace>();
+    endpoint.acquire();
+    race->running = 1;
+    start_racer(race, endpoint, policy, path, header, apply, false);
+
+    std::unique_lock<std::mutex> lock(race->mutex);
+    auto decided = [&race] { return race->decided; };
+    if (!race->decided_changed.wait_for(lock, endpoint.hedge_delay(), decided)) {
+        // 槽位或令牌不够时不发对冲请求，避免在后端已经繁忙时加倍负担
+        if (endpoint.try_acquire()) {
+            ++race->running;
+            lock.unlock();
+            TRACE_COUNT("http.hedge");
+            start_racer(race, endpoint, policy, path, header, apply, true);
+            lock.lock();
+        }
+        race->decided_changed.wait(lock, decided);
+    }
+    if (race->hedge_won) {
+        TRACE_COUNT("http.hedge_win");
+    }
+    return std::move(race->response);
+}
+
+// 会话在调用线程上创建（apply 引用调用方的选项），请求在独立的线程中进行。
+// 落败的请求在后台结束，不阻塞调用方；线程只持有 race、会话和槽位，以及全局的 HttpClient。
+// 线程计入 racers_，析构函数等计数归零，所以线程在减计数之前先释放会话和槽位
+void HttpClient::start_racer(const std::shared_ptr<HedgeRace>& race, EndpointState& endpoint, const RequestPolicy& policy,
+                             const std::string& path, const cpr::Header& header, const ApplyOptions& apply, bool hedge) {
+    auto session = std::make_shared<cpr::Session>();
+    prepare(*session, path, header, policy.timeout);
+    apply(*session);
+    session->SetProgressCallback(cpr::ProgressCallback{
+            [this, race](cpr::cpr_off_t, cpr::cpr_off_t, cpr::cpr_off_t, cpr::cpr_off_t, intptr_t) {
+                return !race->cancelled && !closing_;
+            }});
+
+    {
+        std::lock_guard<std::mutex> lock(racers_mutex_);
+        ++racers_;
+    }
+    std::thread([this, race, session, slot = RequestSlot(&endpoint), &endpoint, path, hedge]() mutable {
+        cpr::Response response = session->Get();
+        slot.release();
+        bool cancelled = race->cancelled;
+        if (cancelled || !should_retry(response)) {
+            endpoint.record_latency(elapsed_ms(response));  // 被中止的请求的耗时是下限，也计入
+        }
+        response = finish(*session, "GET", path, std::move(response));
+        session.reset();  // curl_easy_cleanup 还会访问 share 句柄
+
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            --race->running;
+            if (!race->decided && (!should_retry(response) || race->running == 0)) {
+                race->decided = true;
+                race->hedge_won = hedge;
+                race->response = std::move(response);
+                race->cancelled = true;
+                race->decided_changed.notify_all();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(racers_mutex_);
+        --racers_;
+        racers_done_.notify_all();
+    }).detach();
+}
+
+void HttpClient::prepare(cpr::Session& session, const std::string& path, const cpr::Header& header,
+                         std::chrono::milliseconds timeout) {
+    CURL* handle = session.GetCurlHolder()->handle;
+    curl_easy_setopt(handle, CURLOPT_SHARE, share_);
+    curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "");  // 接受 libcurl 支持的所有压缩格式
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+    curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);  // 优先等待可以多路复用的连接
+
+    cpr::Header merged = header;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!bearer_token_.empty() && !merged.count("Authorization")) {
+        merged["Authorization"] = "Bearer " + bearer_token_;
+    }
+    session.SetUrl(cpr::Url{base_url_ + path});
+    session.SetHeader(merged);
+    session.SetConnectTimeout(cpr::ConnectTimeout{connect_timeout_});
+    session.SetTimeout(cpr::Timeout{timeout.count() > 0 ? timeout : total_timeout_});
+}
+
+cpr::Response HttpClient::finish(cpr::Session& session, const char* method, const std::string& path, cpr::Response response) {
+    CURL* handle = session.GetCurlHolder()->handle;
+    long new_connections = 0;
+    double connect_seconds = 0;
+    double tls_seconds = 0;
+    curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &new_connections);
+    curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME, &connect_seconds);
+    curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME, &tls_seconds);
+    double handshake_seconds = new_connections > 0 ? std::max(connect_seconds, tls_seconds) : 0;
+
+    // 网络耗时由 libcurl 测量，记为刚刚结束的一段
+    static const int http_id = tracer().name_id("http");
+    uint64_t end = tracer().now_ns();
+    tracer().record(http_id, end - std::min<uint64_t>(end, static_cast<uint64_t>(response.elapsed * 1e9)), end);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.requests;
+    stats_.new_connections += new_connections;
+    stats_.total_seconds += response.elapsed;
+    stats_.connect_seconds += handshake_seconds;
+    if (timing_log_.is_open()) {
+        timing_log_ << method << ' ' << path << ' ' << response.status_code << " total_ms=" << response.elapsed * 1000
+                    << " connect_ms=" << handshake_seconds * 1000 << " new_connections=" << new_connections << '\n';
+        timing_log_.flush();
+    }
+    return response;
+}
+
+void HttpClient::lock_share(CURL*, curl_lock_data data, curl_lock_access, void* client) {
+    static_cast<HttpClient*>(client)->share_mutexes_[data].lock();
+}
+
+void HttpClient::unlock_share(CURL*, curl_lock_data data, void* client) {
+    static_cast<HttpClient*>(client)->share_mutexes_[data].unlock();
+}
+
+HttpClient& http_client() {
+    static HttpClient client(URL);
+    return client;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cpr/cpr.h>
+#include <curl/curl.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+#include "request_scheduler.h"
+
+// 请求统计，用于确认连接复用省下的握手
+struct HttpStats {
+    uint64_t requests = 0;
+    uint64_t new_connections = 0;   // 实际新建的连接数，其余请求复用了已有连接
+    double total_seconds = 0;       // 所有请求的总耗时
+    double connect_seconds = 0;     // 其中花在建立连接（含 TLS 握手）上的时间
+};
+
+// 长期存在的 HTTP 客户端：保存后端地址、默认请求头、Bearer 令牌和超时设置。
+// 每个请求使用独立的 cpr::Session（线程安全，也不会残留上一个请求的选项），
+// 但所有会话通过同一个 libcurl share 句柄共享连接池、DNS 和 TLS 会话缓存，
+// 因此多个线程之间也能复用 keep-alive 连接。同时开启 gzip/deflate 压缩，
+// 在 TLS 上协商 HTTP/2，使同一主机的并发请求可以复用一条连接。
+// 所有请求经过 RequestScheduler：按端点限制并发和速率、设置超时；可重放的 GET
+// 在失败时带抖动地重试，策略开启对冲时，超过最近耗时的 p95 仍未完成就再发一个相同的请求
+class HttpClient {
+public:
+    explicit HttpClient(std::string base_url);
+    ~HttpClient();  // 中止还在后台进行的对冲请求，等它们结束后再释放 share 句柄
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    const std::string& base_url() const { return base_url_; }
+
+    void set_bearer_token(const std::string& token);
+    void clear_bearer_token();
+    void set_timeouts(std::chrono::milliseconds connect_timeout, std::chrono::milliseconds total_timeout);
+
+    // 把每个请求的耗时追加写入文件，便于离线分析
+    bool set_timing_log(const std::string& path);
+
+    // path 相对于 base_url；header 会与默认请求头合并；其余参数为 cpr 的请求选项。
+    // 带读写或进度回调的请求不能重放（回调会收到两遍数据），不重试也不对冲
+    template <typename... Options>
+    cpr::Response get(const std::string& path, const cpr::Header& header, Options&&... options) {
+        constexpr bool replayable = !(is_callback<Options>() || ...);
+        return execute("GET", path, header, replayable, [&](cpr::Session& session) { (session.SetOption(options), ...); });
+    }
+
+    template <typename... Options>
+    cpr::Response post(const std::string& path, const cpr::Header& header, Options&&... options) {
+        return execute("POST", path, header, false, [&](cpr::Session& session) { (session.SetOption(options), ...); });
+    }
+
+    HttpStats stats() const;
+
+    // 各端点的调度策略，见 RequestScheduler
+    RequestScheduler& scheduler() { return scheduler_; }
+
+private:
+    struct HedgeRace;
+    using ApplyOptions = std::function<void(cpr::Session&)>;
+
+    template <typename Option>
+    static constexpr bool is_callback() {
+        using T = std::decay_t<Option>;
+        return std::is_same_v<T, cpr::WriteCallback> || std::is_same_v<T, cpr::ReadCallback> ||
+               std::is_same_v<T, cpr::ProgressCallback>;
+    }
+
+    cpr::Response execute(const char* method, const std::string& path, const cpr::Header& header, bool replayable,
+                          const ApplyOptions& apply);
+    cpr::Response perform(EndpointState& endpoint, const RequestPolicy& policy, const char* method, const std::string& path,
+                          const cpr::Header& header, const ApplyOptions& apply);
+    cpr::Response perform_hedged(EndpointState& endpoint, const RequestPolicy& policy, const std::string& path,
+                                 const cpr::Header& header, const ApplyOptions& apply);
+    void start_racer(const std::shared_ptr<HedgeRace>& race, EndpointState& endpoint, const RequestPolicy& policy,
+                     const std::string& path, const cpr::Header& header, const ApplyOptions& apply, bool hedge);
+    void prepare(cpr::Session& session, const std::string& path, const cpr::Header& header, std::chrono::milliseconds timeout);
+    cpr::Response finish(cpr::Session& session, const char* method, const std::string& path, cpr::Response response);
+
+    static void lock_share(CURL* handle, curl_lock_data data, curl_lock_access access, void* client);
+    static void unlock_share(CURL* handle, curl_lock_data data, void* client);
+
+    std::string base_url_;
+    CURLSH* share_;
+    std::mutex share_mutexes_[CURL_LOCK_DATA_LAST];
+
+    mutable std::mutex mutex_;  // 保护下面的设置和统计
+    std::string bearer_token_;
+    std::chrono::milliseconds connect_timeout_{5000};
+    std::chrono::milliseconds total_timeout_{0};  // 策略没有设置超时的端点使用，0 表示不限制
+    HttpStats stats_;
+    std::ofstream timing_log_;
+
+    // 落败的对冲请求在分离的线程中结束，析构时要等它们不再使用 share 句柄和端点状态
+    std::atomic<bool> closing_{false};
+    std::mutex racers_mutex_;
+    std::condition_variable racers_done_;
+    int racers_ = 0;
+
+    RequestScheduler scheduler_;
+};
+
+// 全局 HTTP 客户端，指向 config.h 中的后端地址
+HttpClient& http_client();
@@ -0,0 +1,93 @@
+#include "io_executor.h"
+
+#include <algorithm>
+#include <iterator>
+
+IoExecutor::IoExecutor(size_t thread_count) {
+    thread_count = std::max<size_t>(thread_count, 1);
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back(&IoExecutor::worker_loop, this);
+    }
+}
+
+IoExecutor::~IoExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        jobs_.clear();  // 退出时放弃尚未开始的请求
+        background_jobs_.clear();
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t IoExecutor::poll() {
+    std::deque<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(completion_mutex_);
+        ready.swap(completions_);
+    }
+    for (size_t i = 0; i < ready.size(); ++i) {
+        try {
+            ready[i]();  // 回调先减少对应的计数再执行
+        } catch (...) {
+            // 还没执行的回调放回队列，下一次 poll 继续执行，不会丢失
+            std::lock_guard<std::mutex> lock(completion_mutex_);
+            completions_.insert(completions_.begin(), std::make_move_iterator(ready.begin() + i + 1),
+                                std::make_move_iterator(ready.end()));
+            throw;
+        }
+    }
+    return ready.size();
+}
+
+void IoExecutor::enqueue(bool background, std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        (background ? background_jobs_ : jobs_).push_back(std::move(job));
+    }
+    cv_.notify_one();
+}
+
+void IoExecutor::complete(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(completion_mutex_);
+    completions_.push_back(std::move(callback));
+}
+
+void IoExecutor::worker_loop() {
+    while (true) {
+        std::function<void()> job;
+        bool background;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] {
+                return stopping_ || !jobs_.empty() || (!background_jobs_.empty() && !background_running_);
+            });
+            if (stopping_) {
+                return;
+            }
+            // 普通请求优先；低优先级任务同时只执行一个，其余线程留给普通请求
+            background = jobs_.empty();
+            std::deque<std::function<void()>>& queue = background ? background_jobs_ : jobs_;
+            job = std::move(queue.front());
+            queue.pop_front();
+            background_running_ |= background;
+        }
+        job();
+        if (background) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                background_running_ = false;
+            }
+            cv_.notify_one();  // 下一个低优先级任务可以开始
+        }
+    }
+}
+
+IoExecutor& io_executor() {
+    static IoExecutor executor;
+    return executor;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 后台 I/O 执行器：网络请求在工作线程中执行，结果回调放入完成队列，
+// 由 UI 线程在主循环中调用 poll() 执行，因此回调里可以安全地修改界面状态
+class IoExecutor {
+public:
+    explicit IoExecutor(size_t thread_count = 2);
+    ~IoExecutor();
+
+    IoExecutor(const IoExecutor&) = delete;
+    IoExecutor& operator=(const IoExecutor&) = delete;
+
+    // 在后台执行 work()，完成后在 UI 线程调用 done(work 的返回值)。
+    // work 抛出异常时 done 收到值初始化的结果（如 false、空的 tuple），调用方清理状态的代码总能执行
+    template <typename Work, typename Done>
+    void submit(Work work, Done done) {
+        submit_to(false, std::move(work), std::move(done));
+    }
+
+    // 低优先级的后台任务（如预取）：只在没有普通请求等待时执行，且同时最多占用一个工作线程，
+    // 不会挡住用户直接触发的请求；不计入 in_flight()
+    template <typename Work, typename Done>
+    void submit_background(Work work, Done done) {
+        submit_to(true, std::move(work), std::move(done));
+    }
+
+    // 执行所有已完成请求的回调，返回执行的数量；只能在 UI 线程调用
+    size_t poll();
+
+    // 已提交但回调尚未执行的请求数
+    size_t in_flight() const { return in_flight_; }
+
+private:
+    template <typename Work, typename Done>
+    void submit_to(bool background, Work work, Done done) {
+        using Result = decltype(work());
+        static_assert(std::is_default_constructible_v<Result>, "work() 的返回值在异常时需要值初始化");
+        std::atomic<size_t>& counter = background ? background_in_flight_ : in_flight_;
+        ++counter;
+        enqueue(background, [this, &counter, work = std::move(work), done = std::move(done)]() mutable {
+            std::shared_ptr<Result> result;
+            try {
+                result = std::make_shared<Result>(work());
+            } catch (...) {
+                result = std::make_shared<Result>();  // 请求异常，按失败的结果交给 done
+            }
+            // 先减少计数：done 抛出异常时计数也不会残留
+            complete([&counter, done = std::move(done), result]() mutable {
+                --counter;
+                done(std::move(*result));
+            });
+        });
+    }
+
+    void enqueue(bool background, std::function<void()> job);
+    void complete(std::function<void()> callback);
+    void worker_loop();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> jobs_;
+    std::deque<std::function<void()>> background_jobs_;
+    bool background_running_ = false;  // 已有工作线程在执行低优先级任务
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    std::mutex completion_mutex_;
+    std::deque<std::function<void()>> completions_;
+    std::atomic<size_t> in_flight_{0};
+    std::atomic<size_t> background_in_flight_{0};
+};
+
+// 全局 I/O 执行器
+IoExecutor& io_executor();
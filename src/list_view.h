@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+
+// 虚拟列表的视口：只记录行数、可见行数、选中的行和第一个可见行，不保存行的内容。
+// 每次修改后都重新约束，保证选中的行始终在视口内；绘制时只访问 top() 起的 height() 行
+class ListView {
+public:
+    int count() const { return count_; }
+    int height() const { return height_; }
+    int selected() const { return selected_; }
+    int top() const { return top_; }
+    // 选中的行在视口中的位置
+    int screen_row() const { return selected_ - top_; }
+
+    // 行数变化（加载了新的一页、搜索结果变化）后重新约束选中位置
+    void set_count(int count) {
+        count_ = std::max(count, 0);
+        clamp();
+    }
+
+    void set_height(int height) {
+        height_ = std::max(height, 1);
+        clamp();
+    }
+
+    // 选中 row，视口只在必要时滚动
+    void select(int row) {
+        selected_ = row;
+        clamp();
+    }
+
+    // 选中 row，并尽量让它出现在视口的第 screen_row 行
+    void select_at(int row, int screen_row) {
+        selected_ = row;
+        top_ = row - screen_row;
+        clamp();
+    }
+
+    // 相对移动；wrap 为 true 时越过两端回绕，否则停在两端
+    void move(int delta, bool wrap = false) {
+        if (wrap && count_ > 0) {
+            selected_ = ((selected_ + delta) % count_ + count_) % count_;
+        } else {
+            selected_ += delta;
+        }
+        clamp();
+    }
+
+    // 翻页：选中的行和视口一起移动，选中的行在屏幕上的位置不变
+    void page(int direction) { shift(direction * height_); }
+    void half_page(int direction) { shift(direction * std::max(height_ / 2, 1)); }
+
+    void home() { select(0); }
+    void end() { select(count_ - 1); }
+
+private:
+    void shift(int delta) {
+        top_ += delta;
+        selected_ += delta;
+        clamp();
+    }
+
+    void clamp() {
+        selected_ = std::clamp(selected_, 0, std::max(count_ - 1, 0));
+        top_ = std::min(top_, std::max(count_ - height_, 0));  // 末尾不留空行
+        top_ = std::clamp(top_, std::max(selected_ - height_ + 1, 0), selected_);
+    }
+
+    int count_ = 0;
+    int height_ = 1;
+    int selected_ = 0;
+    int top_ = 0;
+};
@@ -0,0 +1,157 @@
+#include "live_feed.h"
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <utility>
+
+#include "http_client.h"
+#include "post_cache.h"
+#include "post_source.h"
+#include "search_index.h"
+#include "trace.h"
+
+bool fetch_feed_changes(std::string& cursor, int timeout_seconds, FeedChanges& changes, bool& unsupported,
+                        const std::atomic<bool>& cancel) {
+    unsupported = false;
+    changes = FeedChanges{};
+
+    cpr::Parameters parameters{{"timeout", std::to_string(timeout_seconds)}};
+    if (!cursor.empty()) {
+        parameters.Add({"since", cursor});
+    }
+    // 客户端超时比服务器的等待时间稍长；停止订阅时由进度回调中止请求
+    cpr::Response response = http_client().get(
+            "/feed", {}, parameters,
+            cpr::Timeout{std::chrono::milliseconds((timeout_seconds + 10) * 1000)},
+            cpr::ProgressCallback{[&cancel](cpr::cpr_off_t, cpr::cpr_off_t, cpr::cpr_off_t, cpr::cpr_off_t, intptr_t) {
+                return !cancel;
+            }});
+    if (response.status_code == 404) {
+        unsupported = true;
+        return false;
+    }
+    if (response.status_code != 200) {
+        return false;
+    }
+
+    try {
+        TRACE_SCOPE("json_parse");
+        auto body = nlohmann::json::parse(response.text);
+        for (const auto& item : body.value("posts", nlohmann::json::array())) {
+            Post post;
+            post.id = item.at("id").get<int>();
+            post.author_id = item.at("author_id").get<int>();
+            post.title = item.value("title", "");
+            post.content = item.value("content", "");
+            post.published = item.value("published", "");
+            changes.posts.push_back(std::move(post));
+        }
+        for (const auto& id : body.value("deleted", nlohmann::json::array())) {
+            changes.deleted.push_back(id.get<int>());
+        }
+        const auto& next = body.at("cursor");
+        cursor = next.is_string() ? next.get<std::string>() : next.dump();
+    } catch (const std::exception& e) {
+        return false;
+    }
+
+    resolve_author_names(changes.posts);
+    return true;
+}
+
+
+LiveFeed::LiveFeed(int page_size, std::chrono::seconds long_poll, std::chrono::seconds fallback_interval)
+    : page_size_(page_size), long_poll_(long_poll), fallback_interval_(fallback_interval) {}
+
+LiveFeed::~LiveFeed() {
+    stop();
+}
+
+void LiveFeed::start() {
+    if (!thread_.joinable()) {
+        stopping_ = false;
+        thread_ = std::thread(&LiveFeed::run, this);
+    }
+}
+
+void LiveFeed::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool LiveFeed::poll(std::vector<FeedChanges>& changes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.empty()) {
+        return false;
+    }
+    for (auto& item : pending_) {
+        changes.push_back(std::move(item));
+    }
+    pending_.clear();
+    return true;
+}
+
+void LiveFeed::run() {
+    std::string cursor;  // 第一次请求不带游标，服务器立即返回当前游标作为起点
+    std::chrono::milliseconds backoff(1000);
+    while (!stopping_) {
+        FeedChanges changes;
+        bool unsupported;
+        if (fetch_feed_changes(cursor, static_cast<int>(long_poll_.count()), changes, unsupported, stopping_)) {
+            backoff = std::chrono::milliseconds(1000);
+            if (!changes.posts.empty() || !changes.deleted.empty()) {
+                push(std::move(changes));
+            }
+            continue;
+        }
+        if (unsupported) {
+            fallback_ = true;
+            run_fallback();
+            return;
+        }
+        // 连接失败等错误：指数退避后重试
+        if (!sleep_for(backoff)) {
+            return;
+        }
+        backoff = std::min(backoff * 2, std::chrono::milliseconds(60000));
+    }
+}
+
+// 启动时的刷新已经验证过第一页，因此先等待一个间隔再请求
+void LiveFeed::run_fallback() {
+    CacheValidators validators;
+    while (sleep_for(fallback_interval_)) {
+        std::vector<Post> page;
+        if (fetch_and_parse_posts(0, page_size_, page, &validators) && !validators.not_modified) {
+            push(FeedChanges{std::move(page), {}, {}});
+        }
+    }
+}
+
+void LiveFeed::push(FeedChanges changes) {
+    changes.tokens.resize(changes.posts.size());  // 正文在这里切分，UI 线程只合并倒排列表
+    for (size_t i = 0; i < changes.posts.size(); ++i) {
+        if (!changes.posts[i].content.empty()) {
+            changes.tokens[i] = tokenize(changes.posts[i].content);
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(std::move(changes));
+}
+
+bool LiveFeed::sleep_for(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_for(lock, duration, [this] { return stopping_.load(); });
+    return !stopping_;
+}
+
+LiveFeed& live_feed() {
+    static LiveFeed feed;
+    return feed;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "post.h"
+
+// 一次推送的文章变更：新增或修改的文章（服务器顺序，最新的在前）和已删除的文章 id
+struct FeedChanges {
+    std::vector<Post> posts;
+    std::vector<int> deleted;
+    std::vector<std::vector<std::string>> tokens;  // 与 posts 一一对应的正文索引词，由订阅线程切分
+};
+
+// 长轮询 GET /feed?since=<cursor>&timeout=<秒>：服务器在有变更或超时后返回
+//   {"cursor": "...", "posts": [...], "deleted": [...]}
+// cursor 为空时服务器立即返回当前游标。成功时更新 cursor；
+// 后端没有该接口（404）时 unsupported 为 true。cancel 变为 true 时中止请求
+bool fetch_feed_changes(std::string& cursor, int timeout_seconds, FeedChanges& changes, bool& unsupported,
+                        const std::atomic<bool>& cancel);
+
+// 后台订阅文章变更：在独立线程中持续长轮询，收到的变更排队等待 UI 线程取走。
+// 后端不支持 /feed 时改为定期用条件请求重新验证第一页，内容未变时服务器只返回 304。
+// 长轮询会长时间占用线程，因此不使用 io_executor
+class LiveFeed {
+public:
+    explicit LiveFeed(int page_size = 50, std::chrono::seconds long_poll = std::chrono::seconds(25),
+                      std::chrono::seconds fallback_interval = std::chrono::seconds(30));
+    ~LiveFeed();
+
+    LiveFeed(const LiveFeed&) = delete;
+    LiveFeed& operator=(const LiveFeed&) = delete;
+
+    // 启动后台订阅，重复调用无效
+    void start();
+    // 停止订阅并等待后台线程退出
+    void stop();
+
+    // 取出已收到的变更，有变更时返回 true；只能在 UI 线程调用
+    bool poll(std::vector<FeedChanges>& changes);
+
+    // 后端不支持 /feed，正在定期重新验证第一页
+    bool polling_fallback() const { return fallback_; }
+
+private:
+    void run();
+    void run_fallback();
+    void push(FeedChanges changes);
+    // 等待一段时间，期间被 stop() 唤醒时返回 false
+    bool sleep_for(std::chrono::milliseconds duration);
+
+    int page_size_;
+    std::chrono::seconds long_poll_;
+    std::chrono::seconds fallback_interval_;
+
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> fallback_{false};
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<FeedChanges> pending_;
+};
+
+// 全局文章订阅
+LiveFeed& live_feed();
@@ -5,26 +5,64 @@
 #include <ncurses.h>
 #include <algorithm>
 #include <cctype>
-#include <fstream>
+#include <chrono>
+#include <clocale>
+#include <cstdlib>
 #include "form.h"
 
+#include "auth_session.h"
+#include "author_directory.h"
+#include "config.h"
+#include "exporter.h"
+#include "http_client.h"
+#include "io_executor.h"
+#include "list_view.h"
+#include "live_feed.h"
+#include "outbox.h"
+#include "post.h"
+#include "post_source.h"
+#include "post_upload.h"
+#include "prefetcher.h"
+#include "reading_state.h"
+#include "render_scheduler.h"
+#include "text_layout.h"
+#include "text_width.h"
+#include "trace.h"
+#include "window_layout.h"
+
 // pre-declare functions to avoid warnings in the main function
-struct Post;
-std::vector<Post> fetch_and_parse_posts();
-std::string fetch_author_name(int author_id);
 void init_ncurses();
-void display_post(const Post& post, int offset, WINDOW* content_win);
-void handle_user_input(std::vector<Post>& posts, int& index, int& offset, WINDOW* sidebar_win, WINDOW* content_win);
-void display_sidebar(const std::vector<Post>& posts, int current_index, int offset, WINDOW* sidebar_win);
-void display_posts(const std::vector<Post>& posts);
+void display_post(const PostStore& posts, int index, const std::string& content, uint64_t version, int& offset,
+                  WINDOW* content_win);
+attr_t style_attr(uint8_t style);
+void draw_styled_line(WINDOW* win, int y, const StyledText& body, const LineSpan& span, std::string& row);
+void handle_user_input(PostSource& posts, int& offset, WindowLayout& layout);
+void refresh_posts_async(PostSource& posts, int& offset);
+bool handle_search_input(int ch, PostSource& posts, int& offset);
+bool handle_jump_input(int ch);
+void update_search(PostSource& posts, int& offset);
+void keep_selection(PostSource& posts, int selected_id, int& offset);
+int current_post();
+int post_at_row(int row);
+void sync_sidebar_view(const PostSource& posts, WINDOW* sidebar_win);
+void navigate(void (*action)(ListView&), int& offset);
+void track_reading(PostSource& posts, int& offset);
+void select_next_bookmark(PostSource& posts);
+void display_sidebar(const PostStore& posts, const std::vector<int>* rows, const ListView& view, const WindowLayout& layout);
+void display_status(WINDOW* sidebar_win);
+void open_perf_overlay(WINDOW* content_win);
+void display_perf_overlay();
+void render_frame(PostSource& posts, int& offset, const WindowLayout& layout);
+void display_posts(PostSource& posts, int sidebar_width);
 char* trim_whitespaces(char* str);
-bool login_and_save_token(const std::string& username, const std::string& password);
-void post_request_with_token(const std::string& title, const std::string& content);
-void create_post(const std::string& title);
-
-const std::string URL = "http://127.0.0.1:8000";
+long post_request_with_token(const std::string& title, MappedFile& file, size_t offset, size_t length, const std::string& idempotency_key);
+bool create_post(const std::string& title);
+void print_usage();
+bool parse_arguments(int argc, char** argv, int& sidebar_width, bool& export_mode, ExportOptions& options);
+int run_export(const ExportOptions& options);
 
 WINDOW* popup_window = nullptr; // 悬浮窗口的引用
+WINDOW* perf_window = nullptr;   // 性能面板，按 F12 显示或隐藏
 
 enum WindowState {
     BLOG_VIEW,
@@ -33,216 +71,172 @@ enum WindowState {
 
 WindowState current_state = BLOG_VIEW; // 初始状态设置为博客视图
 
-struct Post {
-    std::string title;
-    std::string content;
-    int id;
-    std::string published;
-    int author_id;
-    std::string author_name;  // 新增字段
+std::string status_message;      // 显示在侧边栏底部的状态消息
+LayoutCache post_layouts;        // 文章正文的渲染和折行结果，窗口宽度或正文变化时才重新计算
+Prefetcher prefetcher;           // 在后台准备相邻文章的正文和折行结果
+RenderScheduler render_scheduler;  // 记录下一帧需要重绘的区域
+
+// 搜索状态：按 / 输入查询，侧边栏只显示匹配的文章
+struct SearchState {
+    bool typing = false;       // 正在输入查询
+    std::string query;
+    std::vector<int> matches;  // 匹配文章在列表中的下标，此时 sidebar_view 的行是在 matches 中的位置
+    // 查询还不能过滤（如只输入了一个字母）时侧边栏仍显示完整列表
+    bool active() const { return SearchIndex::filters(query); }
 };
 
+SearchState search_state;
 
-std::vector<Post> fetch_and_parse_posts() {
-    // API 端点
-    std::string url = "http://127.0.0.1:8000/posts";
-
-    // 发送 GET 请求
-    cpr::Response response = cpr::Get(cpr::Url{url});
-
-    // 检查 HTTP 响应状态码
-    if (response.status_code != 200) {
-        std::cerr << "Failed to fetch posts: HTTP " << response.status_code << std::endl;
-        return {};
-    }
-
-    // 解析 JSON 响应
-    auto json_response = nlohmann::json::parse(response.text);
-    std::vector<Post> posts;
-
-    // 迭代 JSON 数组并构造 Post 结构体列表
-    for (const auto& item : json_response) {
-        Post post{
-                item["title"].get<std::string>(),
-                item["content"].get<std::string>(),
-                item["id"].get<int>(),
-                item["published"].get<std::string>(),
-                item["author_id"].get<int>(),
-                fetch_author_name(item["author_id"].get<int>())  // 获取作者名
-        };
-        posts.push_back(post);
-    }
-
-    return posts;
-}
+// 侧边栏的视口：搜索时行是 search_state.matches 中的位置，否则是文章在列表中的下标
+ListView sidebar_view;
 
-std::string fetch_author_name(int author_id) {
-    std::string url = URL + "/users/" + std::to_string(author_id);
-    auto response = cpr::Get(cpr::Url{url});
+// 跳转到第 N 篇文章：输入数字后按 g 或 Enter
+struct JumpState {
+    std::string digits;  // 正在输入的编号
+    int target = -1;     // 等待加载的目标下标，-1 表示没有
+};
 
-    if (response.status_code == 200) {
-        auto json_response = nlohmann::json::parse(response.text);
-        return json_response["username"].get<std::string>();
-    } else {
-        return "Unknown Author";  // 如果请求失败或找不到用户，返回未知作者
-    }
-}
+JumpState jump_state;
 
-bool login_and_save_token(const std::string& username, const std::string& password) {
-    try {
-        // 发送POST请求
-        cpr::Response response = cpr::Post(
-                cpr::Url{URL+"/login"},
-                cpr::Payload{{"username", username}, {"password", password}}
-                //cpr::Header{{"Content-Type", "application/x-www-form-urlencoded"}}
-        );
-
-        // 检查HTTP响应状态码
-        if (response.status_code == 200) {
-            // 解析JSON响应体
-            auto resp_json = nlohmann::json::parse(response.text);
-
-            // 检查JSON对象是否包含"access_token"
-            if (resp_json.contains("access_token")) {
-                std::string token = resp_json["access_token"].get<std::string>();
-
-                // 将令牌保存到文件中
-                std::ofstream token_file("token");
-                if (token_file.is_open()) {
-                    token_file << token;
-                    token_file.close();
-                    return true; // 成功保存令牌
-                } else {
-                    std::cerr << "Failed to open token file for writing.\n";
-                    return false; // 文件打开失败
-                }
-            } else {
-                std::cerr << "Login successful but no access token provided.\n";
-                return false;
-            }
-        } else {
-            // 输出错误消息
-            std::cerr << "Failed to login, status code: " << response.status_code << "\n";
-            std::cerr << "Response: " << response.text << "\n";
-            return false; // 登录失败
-        }
-    } catch (const std::exception& e) {
-        // 捕获并输出异常信息
-        std::cerr << "Exception occurred: " << e.what() << "\n";
-        return false; // 异常情况
-    }
-}
+UploadProgress upload_progress;  // 正在发布的文章的上传进度
+OutboxStatus outbox_status;      // 最近一次读取的发件箱状态
 
-//define a function to make post request with token, the token is stored in a file named "token". the form of data is json, which contains two keys: "title" and "content"
-void post_request_with_token(const std::string& title, const std::string& content) {
-    std::ifstream token_file("token");
-    if (!token_file.is_open()) {
-        std::cerr << "Failed to open token file for reading.\n";
-        return;
+//define a function to make post request with token. the form of data is json, which contains two keys: "title" and "content"
+// 发件箱的发送函数：正文是 file 中 [offset, offset + length) 的部分。
+// 请求体由 PostBodyStream 边转义边生成，通过读回调交给 libcurl，
+// 无论正文多大，内存中只有映射的文件和 libcurl 的发送缓冲区。返回 HTTP 状态码，网络错误时为 0
+long post_request_with_token(const std::string& title, MappedFile& file, size_t offset, size_t length, const std::string& idempotency_key) {
+    std::string token = auth_session().token();  // 即将过期时在发件箱线程中刷新
+    if (token.empty()) {
+        return 401;  // 还没有登录，登录后重试
     }
 
-    std::string token;
-    std::getline(token_file, token);
-    token_file.close();
-
-    std::string url = URL + "/posts";
-
-    nlohmann::json data = {
-        {"title", title},
-        {"content", content}
-    };
-
-    cpr::Response response = cpr::Post(
-            cpr::Url{url},
-            cpr::Header{{"Authorization", "Bearer " + token}},
-            cpr::Body{data.dump()},
-            cpr::Header{{"Content-Type", "application/json"}}
+    PostBodyStream body(title, file.data().substr(offset, length));
+    upload_progress.sent = 0;
+    upload_progress.total = body.size();
+    upload_progress.active = true;
+
+    cpr::Response response = http_client().post(
+            "/posts",
+            // 长度已知，不需要等待服务器的 100 Continue；重发时服务器用幂等键识别同一篇文章
+            cpr::Header{{"Authorization", "Bearer " + token}, {"Content-Type", "application/json"}, {"Expect", ""},
+                        {"Idempotency-Key", idempotency_key}},
+            cpr::ReadCallback{static_cast<cpr::cpr_off_t>(body.size()),
+                              [&body, &file, offset](char* buffer, size_t& size, intptr_t) {
+                                  size = body.read(buffer, size);
+                                  upload_progress.sent += size;
+                                  file.release(offset + body.content_offset());  // 已发送的部分不再占用内存
+                                  return !outbox().stopping();  // 退出时中止，下次启动重发
+                              }}
     );
-
-    if (response.status_code == 201) {
-        //std::cout << "Post created successfully.\n";
-    } else {
-        //std::cerr << "Failed to create post, status code: " << response.status_code << "\n";
-        //std::cerr << "Response: " << response.text << "\n";
+    upload_progress.active = false;
+    if (response.status_code == 401) {
+        auth_session().reject(token);  // 令牌被服务器撤销，下次发送前重新登录
     }
+    return response.status_code;
 }
 
-//define a function to receive title as parameter and read content from post.txt file, then call post_request_with_token function to make post request
-void create_post(const std::string& title) {
+// 把标题和 post.txt 中的正文写入发件箱，写入磁盘后立即返回，由后台发送
+bool create_post(const std::string& title) {
     // 确保标题有效性
     if (title.empty()) {
-        //std::cerr << "Title cannot be empty.\n";
-        return;
-    }
-
-    std::ifstream post_file("./post.txt");
-    if (!post_file.is_open()) {
-        std::cerr << "Failed to open post file for reading.\n";
-        return;
-    }
-
-    std::string content((std::istreambuf_iterator<char>(post_file)), std::istreambuf_iterator<char>());
-
-    // 检查内容是否为空
-    if (content.empty()) {
-        std::cerr << "Content is empty, nothing to post.\n";
-        return;
+        return false;
     }
-
-    post_request_with_token(title, content);
+    return outbox().enqueue(title, "./post.txt");
 }
 
 
 void init_ncurses() {
+    setlocale(LC_ALL, "");  // 按 UTF-8 输出，ncursesw 才能正确显示中文
     initscr();          // 开始 ncurses 模式
     cbreak();           // 行缓冲禁用，传递所有控制信息
     noecho();           // 不显示输入的字符
     keypad(stdscr, TRUE); // 启用键盘映射
     scrollok(stdscr, TRUE); // 允许窗口滚动
+    timeout(100);       // getch 最多等待 100ms，让主循环可以处理后台请求的结果
+    set_escdelay(25);   // Esc 用于退出搜索，不需要等待默认的 1 秒
 
     if (has_colors()) { // 检查终端是否支持颜色
         start_color();
         init_pair(1, COLOR_WHITE, COLOR_BLUE);    // 为侧边栏设置颜色对
         init_pair(2, COLOR_BLACK, COLOR_WHITE);  // 为内容区域设置颜色对
+        init_pair(3, COLOR_YELLOW, COLOR_BLACK);  // 正文中的标题
+        init_pair(4, COLOR_GREEN, COLOR_BLACK);   // 代码
+        init_pair(5, COLOR_CYAN, COLOR_BLACK);    // 链接
+        init_pair(6, COLOR_MAGENTA, COLOR_BLACK); // 引用、列表符号和分隔线
     }
 
     refresh();          // 刷新窗口以显示初始屏幕
 }
 
 
-void display_post(const Post& post, int offset, WINDOW* content_win) {
+void display_post(const PostStore& posts, int index, const std::string& content, uint64_t version, int& offset,
+                  WINDOW* content_win) {
+    TRACE_SCOPE("draw_post");
     werase(content_win);
 
     int max_y, max_x;
     getmaxyx(content_win, max_y, max_x);
 
     int line = 1;
-    std::string title = post.title;
-    int start_pos = (max_x - title.length()) / 2;
-    mvwprintw(content_win, 0, start_pos > 0 ? start_pos : 0, "%s", title.c_str());
-
-    std::istringstream content_stream(post.content);
-    std::string content_line;
-    while (std::getline(content_stream, content_line, '\n')) {
-        size_t pos = 0;
-        while ((pos = content_line.find('\t', pos)) != std::string::npos) {
-            content_line.replace(pos, 1, "    ");
-            pos += 4;
-        }
-
-        int start_index = 0;
-        while (content_line.length() > start_index) {
-            if (line >= max_y - 1) break;
-            mvwprintw(content_win, line++, 0, "%s", content_line.substr(start_index, max_x).c_str());
-            start_index += max_x;
-        }
+    std::string_view title = posts.title(index);
+    int start_pos = (max_x - text_width(title)) / 2;  // 按显示宽度居中，中文标题每个字占 2 列
+    mvwaddnstr(content_win, 0, start_pos > 0 ? start_pos : 0, title.data(), static_cast<int>(title.size()));
+
+    // Markdown 只在正文变化时解析一次，折行结果按宽度缓存，这里只绘制可见的行
+    const PostLayout& layout = post_layouts.get(posts.id(index), version, content, max_x);
+    const std::vector<LineSpan>& lines = layout.lines;
+    int visible_rows = std::max(max_y - 2, 0);  // 第一行是标题，最后一行是作者信息
+    int max_offset = std::max(static_cast<int>(lines.size()) - visible_rows, 0);
+    offset = std::clamp(offset, 0, max_offset);
+
+    std::string row;
+    for (size_t i = offset; i < lines.size() && line < max_y - 1; ++i) {
+        draw_styled_line(content_win, line++, *layout.body, lines[i], row);
     }
 
     if (line < max_y) {
-        mvwprintw(content_win, max_y - 1, 0, "Author: %s, Published: %s", post.author_name.c_str(), post.published.c_str());
+        std::string author(posts.author_name(index));
+        mvwprintw(content_win, max_y - 1, 0, "Author: %s, Published: %s", author.c_str(),
+                  format_timestamp(posts.published(index)).c_str());
+    }
+
+    wnoutrefresh(content_win);
+}
+
+
+// 样式对应的显示属性；颜色只取一种，代码优先于链接、标题和引用
+attr_t style_attr(uint8_t style) {
+    attr_t attr = A_NORMAL;
+    if (style & (STYLE_STRONG | STYLE_HEADING)) attr |= A_BOLD;
+#ifdef A_ITALIC
+    if (style & STYLE_EMPHASIS) attr |= A_ITALIC;
+#else
+    if (style & STYLE_EMPHASIS) attr |= A_UNDERLINE;
+#endif
+    if (style & STYLE_LINK) attr |= A_UNDERLINE;
+    if (has_colors()) {
+        if (style & STYLE_CODE) attr |= COLOR_PAIR(4);
+        else if (style & STYLE_LINK) attr |= COLOR_PAIR(5);
+        else if (style & STYLE_HEADING) attr |= COLOR_PAIR(3);
+        else if (style & (STYLE_QUOTE | STYLE_MARKER)) attr |= COLOR_PAIR(6);
     }
+    return attr;
+}
 
-    wrefresh(content_win);
+
+// 绘制折行后的一行：从包含行首的样式段开始，逐段设置属性写入
+void draw_styled_line(WINDOW* win, int y, const StyledText& body, const LineSpan& span, std::string& row) {
+    wmove(win, y, 0);
+    size_t end = span.offset + span.length;
+    for (size_t run = body.run_at(span.offset), pos = span.offset; pos < end; ++run) {
+        size_t next = std::min(body.run_end(run), end);
+        std::string_view text = expand_tabs(std::string_view(body.text).substr(pos, next - pos), row);
+        wattrset(win, style_attr(body.runs[run].style));
+        waddnstr(win, text.data(), static_cast<int>(text.size()));
+        pos = next;
+    }
+    wattrset(win, A_NORMAL);
 }
 
 
@@ -276,8 +270,11 @@ void handle_view_change_input() {
 }
 */
 
-void handle_user_input(std::vector<Post>& posts, int& index, int& offset,int& sidebar_offset, WINDOW* sidebar_win, WINDOW* content_win) {
+void handle_user_input(PostSource& posts, int& offset, WindowLayout& layout) {
     int ch = getch();
+    if (handle_search_input(ch, posts, offset) || handle_jump_input(ch)) {
+        return;
+    }
     switch (ch) {
         case KEY_F(1):
             if (current_state == BLOG_VIEW) {
@@ -347,35 +344,6 @@ void handle_user_input(std::vector<Post>& posts, int& index, int& offset,int& si
                 std::string username = trim_whitespaces(field_buffer(field[0], 0));
                 std::string password = trim_whitespaces(field_buffer(field[1], 0));
 
-                //char* username = trim_whitespaces(field_buffer(field[0], 0));
-                //char* password = trim_whitespaces(field_buffer(field[1], 0));
-                //std::cerr << password << "\n";
-                if (login_and_save_token(username, password)) {
-                    // 登录并保存令牌
-                    // 关闭表单和窗口
-                    unpost_form(form);
-                    free_form(form);
-                    for (int i = 0; field[i]; i++) {
-                        free_field(field[i]);
-                    }
-                    delwin(popup_window);
-                    popup_window = nullptr;
-                    current_state = BLOG_VIEW; // 返回博客视图
-                } else {
-                    // 登录失败
-                    mvwprintw(popup_window, 4, 1, "Login failed. Press F1 to close.");
-                    wrefresh(popup_window);
-                    while (getch() != KEY_F(1)); // 等待用户按下F1键
-                    unpost_form(form);
-                    free_form(form);
-                    for (int i = 0; field[i]; i++) {
-                        free_field(field[i]);
-                    }
-                    delwin(popup_window);
-                    popup_window = nullptr;
-                    current_state = BLOG_VIEW; // 返回博客视图
-                }; // 登录并保存令牌
-                /*
                 // 关闭表单和窗口
                 unpost_form(form);
                 free_form(form);
@@ -385,20 +353,29 @@ void handle_user_input(std::vector<Post>& posts, int& index, int& offset,int& si
                 delwin(popup_window);
                 popup_window = nullptr;
                 current_state = BLOG_VIEW; // 返回博客视图
-                 */
+
+                // 登录请求在后台执行，结果显示在状态栏
+                status_message = "Logging in...";
+                io_executor().submit(
+                        [username, password]() { return auth_session().login(username, password); },
+                        [](bool ok) {
+                            status_message = ok ? "Logged in." : "Login failed.";
+                            if (ok) {
+                                outbox().retry_now();  // 等待登录的文章立即发送
+                            }
+                        });
             }
             clear();
-            refresh();
+            render_scheduler.invalidate(DIRTY_ALL);  // 悬浮窗口关闭后整屏重绘
             break;
 
 
         case KEY_F(2):
-            //check if token file exists
+            //check if logged in
             if (current_state == BLOG_VIEW) {
 
-                std::ifstream token_file("token");
-                if (!token_file.is_open()) {
-                    //if token file does not exist, show a message on popup window and press esc to close
+                if (!auth_session().logged_in()) {
+                    //if not logged in, show a message on popup window and press esc to close
                     if (!popup_window) {
                         popup_window = newwin(10, 50, 6, 10); // 创建新窗口，尺寸和位置可以根据需要调整
                         box(popup_window, 0, 0); // 给悬浮窗口加边框
@@ -410,7 +387,7 @@ void handle_user_input(std::vector<Post>& posts, int& index, int& offset,int& si
                     delwin(popup_window);
                     popup_window = nullptr;
                     clear();
-                    refresh();
+                    render_scheduler.invalidate(DIRTY_ALL);
                     break;
                 }
 
@@ -468,7 +445,12 @@ void handle_user_input(std::vector<Post>& posts, int& index, int& offset,int& si
                 form_driver(form, REQ_FIRST_FIELD);
 
                 std::string title = trim_whitespaces(field_buffer(field[0], 0));
-                create_post(title);
+                if (!title.empty()) {
+                    // 写入发件箱也在后台执行（正文可能很大），发送进度显示在状态栏
+                    io_executor().submit(
+                            [title]() { return create_post(title); },
+                            [](bool ok) { status_message = ok ? "Post queued." : "Failed to queue post."; });
+                }
 
                 // 关闭表单和窗口
                 unpost_form(form);
@@ -480,49 +462,321 @@ void handle_user_input(std::vector<Post>& posts, int& index, int& offset,int& si
                 popup_window = nullptr;
                 current_state = BLOG_VIEW; // 返回博客视图
                 clear();
-                refresh();
+                render_scheduler.invalidate(DIRTY_ALL);
             }
             break;
 
 
         case KEY_DOWN:
             offset++; // 向下滚动
+            render_scheduler.invalidate(DIRTY_CONTENT);
             break;
         case KEY_UP:
             if (offset > 0) offset--; // 向上滚动
+            render_scheduler.invalidate(DIRTY_CONTENT);
             break;
         case 'q':   // 按 'q' 退出
+            posts.save_cache(POST_CACHE_FILE);  // 保存列表和正文，下次启动直接显示
             endwin();
             exit(0);
         case KEY_NPAGE:
-            if (sidebar_offset <= posts.size()-2) {
-                sidebar_offset++; // 向下滚动侧边栏
-            }else {
-                sidebar_offset = 0;
+            // 下一篇；列表还没加载完时停在末尾，等待下一页
+            if (search_state.active() || posts.exhausted()) {
+                navigate([](ListView& view) { view.move(1, true); }, offset);
+            } else {
+                navigate([](ListView& view) { view.move(1); }, offset);
             }
-            index = (index + 1) % posts.size(); // 下一个帖子
-            offset = 0; // 重置偏移量
             break;
         case KEY_PPAGE:
-            if (sidebar_offset > 0) {
-                sidebar_offset--; // 向上滚动侧边栏
-            }else{
-                sidebar_offset = posts.size()-1;
+            if (search_state.active() || posts.exhausted()) {
+                navigate([](ListView& view) { view.move(-1, true); }, offset);
+            } else {
+                navigate([](ListView& view) { view.move(-1); }, offset);
+            }
+            break;
+        case KEY_HOME:
+            navigate([](ListView& view) { view.home(); }, offset);
+            break;
+        case KEY_END:
+            navigate([](ListView& view) { view.end(); }, offset);  // 未加载完时到已加载的末尾，并继续加载
+            break;
+        case 4:  // Ctrl-D 向下翻半屏
+            navigate([](ListView& view) { view.half_page(1); }, offset);
+            break;
+        case 21:  // Ctrl-U 向上翻半屏
+            navigate([](ListView& view) { view.half_page(-1); }, offset);
+            break;
+        case KEY_SF:  // Shift+下 向下翻一屏
+            navigate([](ListView& view) { view.page(1); }, offset);
+            break;
+        case KEY_SR:  // Shift+上 向上翻一屏
+            navigate([](ListView& view) { view.page(-1); }, offset);
+            break;
+        case 'u':  // 当前文章在已读和未读之间切换
+        case 'b': {  // 添加或取消书签
+            int index = current_post();
+            if (index >= 0) {
+                int id = posts.id(index);
+                if (ch == 'u') reading_state().set_read(id, !reading_state().is_read(id));
+                else reading_state().set_bookmarked(id, !reading_state().is_bookmarked(id));
+                render_scheduler.invalidate(DIRTY_SIDEBAR);
             }
-            if (--index < 0) index = posts.size() - 1;
-            offset = 0; // 重置偏移量
+            break;
+        }
+        case 'B':  // 下一篇有书签的文章
+            select_next_bookmark(posts);
             break;
         case KEY_F(5):  // F5 键刷新
-            posts = fetch_and_parse_posts();  // 重新获取文章列表
-            if (posts.empty()) {
-                printw("No posts available or failed to fetch posts.");
-                refresh();
+            refresh_posts_async(posts, offset);  // 在后台重新获取文章列表
+            break;
+        case KEY_F(12):  // F12 显示或隐藏性能面板
+            if (perf_window) {
+                delwin(perf_window);
+                perf_window = nullptr;
+            } else {
+                open_perf_overlay(layout.content());
             }
-            index = 0;  // 重置到第一个帖子
-            offset = 0; // 重置滚动偏移量
-            display_sidebar(posts, index,sidebar_offset, sidebar_win);  // 重新显示侧边栏
-            display_post(posts[index], offset, content_win);  // 重新显示内容
+            render_scheduler.invalidate(DIRTY_CONTENT | DIRTY_OVERLAY);  // 关闭时重绘面板下面的正文
+            break;
+        case '[':  // 侧边栏变窄
+        case ']':  // 侧边栏变宽
+            layout.set_sidebar_width(layout.sidebar_width() + (ch == ']' ? 1 : -1));
             break;
+        case KEY_RESIZE:  // 终端大小变化，ncurses 已更新 LINES/COLS
+            layout.update();
+            break;
+    }
+}
+
+
+// 在后台重新验证文章列表的第一页，完成后仍然选中原来的文章
+void refresh_posts_async(PostSource& posts, int& offset) {
+    int selected = current_post();
+    posts.refresh([&posts, &offset, selected_id = selected >= 0 ? posts.id(selected) : -1]() {
+        keep_selection(posts, selected_id, offset);
+        if (!posts.load_error().empty()) {
+            status_message = posts.load_error();
+        } else {
+            status_message = posts.empty() ? "No posts available." : "";
+        }
+    });
+}
+
+
+// 当前选中的文章在列表中的下标，没有时返回 -1
+int current_post() {
+    return post_at_row(sidebar_view.selected());
+}
+
+// 侧边栏第 row 行对应的文章在列表中的下标，超出范围时返回 -1
+int post_at_row(int row) {
+    if (row < 0) {
+        return -1;
+    }
+    if (search_state.active()) {
+        const std::vector<int>& matches = search_state.matches;
+        return row < static_cast<int>(matches.size()) ? matches[row] : -1;
+    }
+    return row < sidebar_view.count() ? row : -1;
+}
+
+
+// 让视口的行数和高度与当前列表一致，最后一行留给状态栏
+void sync_sidebar_view(const PostSource& posts, WINDOW* sidebar_win) {
+    sidebar_view.set_count(search_state.active() ? static_cast<int>(search_state.matches.size()) : posts.size());
+    sidebar_view.set_height(getmaxy(sidebar_win) - 1);
+}
+
+
+// 移动侧边栏的选择；选中的文章变化时，正文的滚动位置由 track_reading 恢复为上次离开时的位置
+void navigate(void (*action)(ListView&), int& offset) {
+    int before = current_post();
+    action(sidebar_view);
+    if (current_post() != before) {
+        offset = 0;
+    }
+    jump_state = JumpState{};
+    render_scheduler.invalidate(DIRTY_SIDEBAR | DIRTY_CONTENT);
+}
+
+
+// 记录选中的文章和它的滚动位置；选中另一篇文章时恢复它上次的滚动位置。
+// 正文第一次显示出来后标记为已读，每次选中只自动标记一次，按 u 改回未读后不会马上又变成已读
+void track_reading(PostSource& posts, int& offset) {
+    static int visiting = -1;
+    static bool marked = false;
+    int index = current_post();
+    int id = index >= 0 ? posts.id(index) : -1;
+    if (id != visiting) {
+        visiting = id;
+        marked = false;
+        if (id >= 0) {
+            offset = reading_state().offset(id);
+            reading_state().set_position(id);
+            render_scheduler.invalidate(DIRTY_CONTENT);
+        }
+    }
+    if (id < 0) {
+        return;
+    }
+    reading_state().set_offset(id, offset);
+    if (!marked && posts.cached_content(id)) {
+        marked = true;
+        if (!reading_state().is_read(id)) {
+            reading_state().set_read(id, true);
+            render_scheduler.invalidate(DIRTY_SIDEBAR);
+        }
+    }
+}
+
+
+// 选中当前文章之后（到末尾后从头开始）第一篇有书签的文章，只在已加载的文章中查找
+void select_next_bookmark(PostSource& posts) {
+    int rows = sidebar_view.count();
+    for (int step = 1; step <= rows; ++step) {
+        int row = (sidebar_view.selected() + step) % rows;
+        if (reading_state().is_bookmarked(posts.id(post_at_row(row)))) {
+            sidebar_view.select(row);
+            jump_state = JumpState{};
+            render_scheduler.invalidate(DIRTY_SIDEBAR | DIRTY_CONTENT);
+            return;
+        }
+    }
+    status_message = "No bookmarks.";
+    render_scheduler.invalidate(DIRTY_STATUS);
+}
+
+
+// 列表变化后仍然选中同一篇文章，并让它停留在侧边栏的同一行；
+// 文章已被删除时选中原位置上的文章
+void keep_selection(PostSource& posts, int selected_id, int& offset) {
+    int old_index = current_post();
+    int screen_row = sidebar_view.screen_row();
+    int new_index = posts.index_of(selected_id);
+    if (new_index < 0) {
+        new_index = std::min(std::max(old_index, 0), std::max(posts.size() - 1, 0));
+        offset = 0;
+    }
+
+    int row = new_index;
+    if (search_state.active()) {
+        // 下标已经变化，搜索结果需要重新计算
+        std::vector<int>& matches = search_state.matches;
+        matches = posts.search(search_state.query);
+        auto it = std::lower_bound(matches.begin(), matches.end(), new_index);
+        row = it != matches.end() && *it == new_index ? static_cast<int>(it - matches.begin()) : 0;
+        sidebar_view.set_count(static_cast<int>(matches.size()));
+    } else {
+        sidebar_view.set_count(posts.size());
+    }
+    sidebar_view.select_at(row, screen_row);
+    render_scheduler.invalidate(DIRTY_SIDEBAR | DIRTY_CONTENT);
+}
+
+
+// 处理跳转相关的按键，返回 true 表示按键已被处理
+bool handle_jump_input(int ch) {
+    if (current_state != BLOG_VIEW) {
+        return false;
+    }
+    if (ch >= '0' && ch <= '9' && jump_state.digits.size() < 9) {
+        jump_state.digits.push_back(static_cast<char>(ch));
+        render_scheduler.invalidate(DIRTY_STATUS);
+        return true;
+    }
+    if (jump_state.digits.empty()) {
+        return false;
+    }
+    if (ch == 'g' || ch == '\n' || ch == KEY_ENTER) {
+        jump_state.target = std::max(std::stoi(jump_state.digits), 1) - 1;  // 编号从 1 开始，由主循环执行跳转
+        jump_state.digits.clear();
+        render_scheduler.invalidate(DIRTY_STATUS);
+        return true;
+    }
+    if (ch == 27 || ch == KEY_BACKSPACE || ch == 127 || ch == 8) {
+        jump_state = JumpState{};
+        render_scheduler.invalidate(DIRTY_STATUS);
+        return true;
+    }
+    return false;
+}
+
+
+// 处理搜索相关的按键，返回 true 表示按键已被处理
+// 输入查询时可打印字符写入查询，Enter 结束输入并保留过滤，Esc 清除过滤
+bool handle_search_input(int ch, PostSource& posts, int& offset) {
+    if (!search_state.typing) {
+        if (ch == '/' && current_state == BLOG_VIEW) {
+            search_state.typing = true;
+            if (!search_state.active()) {
+                search_state.query.clear();  // 没有生效的查询不保留
+            }
+            render_scheduler.invalidate(DIRTY_STATUS);
+            return true;
+        }
+        if (ch == 27 && search_state.active()) {
+            search_state.query.clear();
+            update_search(posts, offset);
+            return true;
+        }
+        return false;
+    }
+
+    switch (ch) {
+        case '\n':
+        case KEY_ENTER:
+            search_state.typing = false;
+            render_scheduler.invalidate(DIRTY_STATUS);
+            return true;
+        case 27:  // Esc
+            search_state.typing = false;
+            search_state.query.clear();
+            update_search(posts, offset);
+            return true;
+        case KEY_BACKSPACE:
+        case 127:
+        case 8:
+            // 删除最后一个完整的 UTF-8 字符
+            while (!search_state.query.empty() && (search_state.query.back() & 0xC0) == 0x80) {
+                search_state.query.pop_back();
+            }
+            if (!search_state.query.empty()) {
+                search_state.query.pop_back();
+            }
+            update_search(posts, offset);
+            return true;
+        default:
+            // 多字节字符按字节逐个到达，直接拼接
+            if (ch >= 32 && ch < 256 && ch != 127) {
+                search_state.query.push_back(static_cast<char>(ch));
+                update_search(posts, offset);
+                return true;
+            }
+            return false;  // 方向键、翻页等仍按正常方式处理
+    }
+}
+
+
+// 重新计算搜索结果；当前文章仍在结果中时保持选中，否则选中第一个结果
+void update_search(PostSource& posts, int& offset) {
+    render_scheduler.invalidate(DIRTY_SIDEBAR | DIRTY_CONTENT);
+    int index = current_post();  // 按旧的结果计算
+    if (!search_state.active()) {
+        search_state.matches.clear();
+        sidebar_view.set_count(posts.size());
+        sidebar_view.select(std::max(index, 0));  // 恢复为在完整列表中选中当前文章
+        return;
+    }
+
+    std::vector<int>& matches = search_state.matches;
+    matches = posts.search(search_state.query);
+    sidebar_view.set_count(static_cast<int>(matches.size()));
+    auto it = std::lower_bound(matches.begin(), matches.end(), index);
+    if (it != matches.end() && *it == index) {
+        sidebar_view.select(static_cast<int>(it - matches.begin()));
+    } else {
+        sidebar_view.select_at(0, 0);
+        offset = 0;
     }
 }
 
@@ -547,63 +801,400 @@ char* trim_whitespaces(char* str) {
     return trimmed;
 }
 
-void display_sidebar(const std::vector<Post>& posts, int current_index, int offset, WINDOW* sidebar_win) {
+// rows 不为空时只显示其中列出的文章（搜索结果），view 的行是 rows 中的位置。
+// 只绘制视口中可见的行，与列表长度无关；未读的文章加粗，有书签的加下划线，阅读状态从内存中查询
+void display_sidebar(const PostStore& posts, const std::vector<int>* rows, const ListView& view, const WindowLayout& layout) {
+    TRACE_SCOPE("draw_sidebar");
+    WINDOW* sidebar_win = layout.sidebar();
     werase(sidebar_win);  // 清除侧边栏窗口
-    int max_y, max_x;
-    getmaxyx(sidebar_win, max_y, max_x); // 获取侧边栏窗口的大小
-    for (int i = 0; i < max_y && i + offset < posts.size(); ++i) {
-        if (i + offset == current_index) {
-            wattron(sidebar_win, A_REVERSE);  // 开启反向高亮
+    int row_count = rows ? static_cast<int>(rows->size()) : static_cast<int>(posts.size());
+    int end = std::min(view.top() + view.height(), row_count);
+    int label_columns = layout.label_columns();
+    std::string resized;
+    for (int row = view.top(); row < end; ++row) {
+        int post_index = rows ? (*rows)[row] : row;
+        ReadingEntry reading = reading_state().get(posts.id(post_index));
+        attr_t attrs = (row == view.selected() ? A_REVERSE : A_NORMAL) | (reading.read ? A_NORMAL : A_BOLD) |
+                       (reading.bookmarked ? A_UNDERLINE : A_NORMAL);
+        wattron(sidebar_win, attrs);
+        // 默认宽度下使用预先截断的标题，不需要复制；调整过宽度时只为可见的行重新截断
+        std::string_view label = posts.label(post_index);
+        if (label_columns != SIDEBAR_LABEL_COLUMNS) {
+            resized = make_label(posts.title(post_index), label_columns);
+            label = resized;
         }
-        std::string title = posts[i + offset].title;
-        if (title.size() > 20) {
-            title = title.substr(0, 20) + "...";
+        mvwaddnstr(sidebar_win, row - view.top(), 0, label.data(), static_cast<int>(label.size()));
+        wattroff(sidebar_win, attrs);
+    }
+    display_status(sidebar_win);
+    wnoutrefresh(sidebar_win);  // 更新到虚拟屏幕，由 render_frame 统一输出
+}
+
+
+// 在侧边栏最后一行显示后台请求的进度或最近的状态消息
+void display_status(WINDOW* sidebar_win) {
+    static const char spinner[] = "|/-\\";
+    static int frame = 0;
+
+    int max_y, max_x;
+    getmaxyx(sidebar_win, max_y, max_x);
+    wmove(sidebar_win, max_y - 1, 0);
+    wclrtoeol(sidebar_win);
+    if (search_state.typing) {
+        mvwprintw(sidebar_win, max_y - 1, 0, "/%.*s", max_x - 1, search_state.query.c_str());
+    } else if (!jump_state.digits.empty()) {
+        mvwprintw(sidebar_win, max_y - 1, 0, "Go to: %s", jump_state.digits.c_str());
+    } else if (upload_progress.active && upload_progress.total > 0) {
+        mvwprintw(sidebar_win, max_y - 1, 0, "Publishing %d%%",
+                  static_cast<int>(upload_progress.sent * 100 / upload_progress.total));
+    } else if (io_executor().in_flight() > 0) {
+        frame = (frame + 1) % 4;
+        mvwprintw(sidebar_win, max_y - 1, 0, "[%c] Loading...", spinner[frame]);
+    } else if (outbox_status.pending > 0) {
+        if (outbox_status.retry_in_seconds > 0) {
+            mvwprintw(sidebar_win, max_y - 1, 0, "Outbox %zu, retry %ds", outbox_status.pending, outbox_status.retry_in_seconds);
+        } else {
+            mvwprintw(sidebar_win, max_y - 1, 0, "Outbox %zu, sending", outbox_status.pending);
         }
-        mvwprintw(sidebar_win, i, 0, "%s", title.c_str());
-        if (i + offset == current_index) {
-            wattroff(sidebar_win, A_REVERSE);  // 关闭反向高亮
+    } else if (search_state.active()) {
+        mvwprintw(sidebar_win, max_y - 1, 0, "/%s (%zu)", search_state.query.c_str(), search_state.matches.size());
+    } else {
+        mvwprintw(sidebar_win, max_y - 1, 0, "%.*s", max_x, status_message.c_str());
+    }
+}
+
+
+// 在正文区域的右上角创建性能面板
+void open_perf_overlay(WINDOW* content_win) {
+    int width = std::min(46, getmaxx(content_win));
+    perf_window = newwin(std::min(14, getmaxy(content_win)), width, getbegy(content_win),
+                         getbegx(content_win) + getmaxx(content_win) - width);
+}
+
+// 性能面板：各段耗时的次数和分位数（启动以来的累计），缓存命中率，以及请求的重试、对冲（胜出/发出）和限流次数
+void display_perf_overlay() {
+    static const char* const spans[] = {"http", "json_parse", "fetch_posts", "fetch_content", "fetch_author",
+                                        "layout", "draw_sidebar", "draw_post", "frame"};
+    werase(perf_window);
+    box(perf_window, 0, 0);
+    mvwprintw(perf_window, 0, 2, " Performance (F12) ");
+    mvwprintw(perf_window, 1, 2, "%-13s %7s %8s %8s", "", "count", "p50 ms", "p99 ms");
+    int y = 2;
+    for (const char* name : spans) {
+        SpanStats stats = tracer().span(name);
+        mvwprintw(perf_window, y++, 2, "%-13s %7llu %8.2f %8.2f", name, static_cast<unsigned long long>(stats.count),
+                  stats.p50_ms, stats.p99_ms);
+    }
+
+    auto hit_rate = [](uint64_t hits, uint64_t misses) {
+        return hits + misses == 0 ? std::string("-") : std::to_string(hits * 100 / (hits + misses)) + "%";
+    };
+    std::string layout = hit_rate(tracer().counter("layout_cache.hit"), tracer().counter("layout_cache.miss"));
+    std::string content = hit_rate(tracer().counter("content_cache.hit") + tracer().counter("content_cache.disk"),
+                                   tracer().counter("content_cache.miss"));
+    std::string author = hit_rate(tracer().counter("author_cache.hit"), tracer().counter("author_cache.miss"));
+    mvwprintw(perf_window, y++, 2, "hit: layout %s content %s author %s", layout.c_str(), content.c_str(), author.c_str());
+    mvwprintw(perf_window, y, 2, "http: retry %llu hedge %llu/%llu throttled %llu",
+              static_cast<unsigned long long>(tracer().counter("http.retry")),
+              static_cast<unsigned long long>(tracer().counter("http.hedge_win")),
+              static_cast<unsigned long long>(tracer().counter("http.hedge")),
+              static_cast<unsigned long long>(tracer().counter("http.throttled")));
+    wnoutrefresh(perf_window);
+}
+
+
+// 只重绘上一帧之后变化的区域，所有窗口先写入虚拟屏幕，最后一次性输出
+void render_frame(PostSource& posts, int& offset, const WindowLayout& layout) {
+    unsigned dirty = render_scheduler.take();
+    if (dirty == DIRTY_NONE) {
+        return;
+    }
+    TRACE_SCOPE("frame");
+
+    WINDOW* sidebar_win = layout.sidebar();
+    WINDOW* content_win = layout.content();
+    if (dirty & DIRTY_FRAME) {
+        // 分隔线的位置和高度由布局缓存；清除了整个屏幕，其余部分也要重绘
+        layout.draw_separator();
+        dirty |= DIRTY_SIDEBAR | DIRTY_CONTENT | DIRTY_OVERLAY;
+    }
+
+    if (dirty & DIRTY_SIDEBAR) {
+        display_sidebar(posts.posts(), search_state.active() ? &search_state.matches : nullptr, sidebar_view, layout);
+    } else if (dirty & DIRTY_STATUS) {
+        display_status(sidebar_win);
+        wnoutrefresh(sidebar_win);
+    }
+
+    if (dirty & DIRTY_CONTENT) {
+        int index = current_post();
+        if (index >= 0) {
+            // 正文在第一次显示时才请求；请求失败时显示原因，退避后自动重试
+            static const std::string loading = "Loading...";
+            int post_id = posts.id(index);
+            const std::string* content = posts.content(post_id);
+            int loading_offset = 0;  // 正文加载之前不改变恢复的滚动位置
+            if (content) {
+                display_post(posts.posts(), index, *content, posts.content_version(post_id), offset, content_win);
+            } else if (const std::string* error = posts.content_error(post_id)) {
+                // 每次失败版本都会变化，不会与正文或之前的错误信息的折行结果混淆
+                display_post(posts.posts(), index, "Failed to load post: " + *error + "\n\nRetrying automatically.",
+                             posts.content_version(post_id), loading_offset, content_win);
+            } else {
+                display_post(posts.posts(), index, loading, 0, loading_offset, content_win);  // 有正文时版本总是大于 0
+            }
+        } else {
+            werase(content_win);
+            wnoutrefresh(content_win);
         }
     }
-    wrefresh(sidebar_win);  // 刷新侧边栏窗口以显示更新的内容
+
+    // 面板覆盖在正文上，正文重绘后也要重绘
+    if (perf_window && (dirty & (DIRTY_CONTENT | DIRTY_OVERLAY))) {
+        display_perf_overlay();
+    }
+
+    doupdate();
 }
 
 
-void display_posts(const std::vector<Post>& posts) {
-    int index = 0;
+void display_posts(PostSource& posts, int sidebar_width) {
     int offset = 0;
-    int sidebar_offset = 0;
-    WINDOW* sidebar_win = newwin(getmaxy(stdscr), 23, 0, 0);  // 创建侧边栏窗口，宽度为20
-    WINDOW* content_win = newwin(getmaxy(stdscr), getmaxx(stdscr) - 25, 0, 25);  // 创建内容窗口
+    uint64_t overlay_updated = 0;
+    std::string load_error;  // 已经显示过的加载列表的错误
+    std::string auth_error;  // 已经显示过的后台刷新令牌的错误
+    bool reading_write_failed = false;
+    WindowLayout layout(sidebar_width);
+    layout.on_change([&posts, &layout](unsigned changes) {
+        if (changes & LAYOUT_CONTENT_WIDTH) {
+            // 旧宽度的后台折行不再需要；缓存按宽度区分，当前文章在下一次绘制时按新宽度折行，不重新解析
+            prefetcher.reset();
+        }
+        if (perf_window) {
+            delwin(perf_window);
+            open_perf_overlay(layout.content());
+        }
+        sync_sidebar_view(posts, layout.sidebar());
+        render_scheduler.invalidate(DIRTY_ALL);
+    });
+    layout.create();
+
+    // 回到上次选中的文章，滚动位置由 track_reading 恢复；它不在缓存的列表中时从头开始
+    int last_index = posts.index_of(reading_state().position());
+    if (last_index >= 0) {
+        sidebar_view.select_at(last_index, sidebar_view.height() / 2);
+    }
+
+    refresh_posts_async(posts, offset);  // 首次加载或重新验证缓存也在后台进行
+    live_feed().start();  // 之后的新文章和修改由后台订阅推送
 
     while (true) {
+        bool changed = io_executor().poll() > 0;
+        if (changed) {
+            // 后台请求可能改变了列表、正文或状态消息
+            render_scheduler.invalidate(DIRTY_SIDEBAR | DIRTY_CONTENT);
+        }
+        std::vector<FeedChanges> feed_changes;
+        if (live_feed().poll(feed_changes)) {
+            // 订阅推送的新增、修改和删除只更新变化的文章，选择和滚动位置保持不变
+            int selected = current_post();
+            int selected_id = selected >= 0 ? posts.id(selected) : -1;
+            for (auto& item : feed_changes) {
+                posts.apply_changes(std::move(item));
+            }
+            keep_selection(posts, selected_id, offset);
+            changed = true;
+        }
+        changed |= posts.index_idle(32);  // 空闲时逐步为缓存的正文建立索引
+        if (changed && search_state.active()) {
+            update_search(posts, offset);  // 新文章或新索引可能改变搜索结果
+        }
+        // 弹出窗口中的 getch 也可能收到 KEY_RESIZE，这里按 LINES/COLS 再检查一次
+        layout.update();
+        sync_sidebar_view(posts, layout.sidebar());
+        if (posts.load_error() != load_error) {
+            load_error = posts.load_error();
+            if (!load_error.empty()) {
+                status_message = load_error;  // 分页请求失败，列表停在已加载的位置
+            }
+            render_scheduler.invalidate(DIRTY_STATUS);
+        }
+        std::string latest_auth_error = auth_session().last_error();
+        if (latest_auth_error != auth_error) {
+            auth_error = latest_auth_error;
+            if (!auth_error.empty()) {
+                status_message = auth_error;  // 登录或后台重新登录失败的原因
+            }
+            render_scheduler.invalidate(DIRTY_STATUS);
+        }
+        if (reading_state().write_failed() != reading_write_failed) {
+            reading_write_failed = !reading_write_failed;
+            if (reading_write_failed) {
+                status_message = "Failed to write " + READING_STATE_FILE;
+                render_scheduler.invalidate(DIRTY_STATUS);
+            }
+        }
+        OutboxStatus latest_outbox = outbox().status();
+        if (latest_outbox != outbox_status) {
+            // 发件箱的积压、重试倒计时或错误变化时更新状态栏
+            if (latest_outbox.last_error != outbox_status.last_error && !latest_outbox.last_error.empty()) {
+                status_message = "Outbox: " + latest_outbox.last_error;
+            }
+            outbox_status = latest_outbox;
+            render_scheduler.invalidate(DIRTY_STATUS);
+        }
+        if (upload_progress.active || io_executor().in_flight() > 0) {
+            render_scheduler.invalidate(DIRTY_STATUS);  // 转动进度指示
+        }
+        if (perf_window && tracer().now_ns() - overlay_updated >= 500'000'000) {
+            overlay_updated = tracer().now_ns();  // 性能面板每 0.5 秒刷新一次
+            render_scheduler.invalidate(DIRTY_OVERLAY);
+        }
+        if (jump_state.target >= 0) {
+            // 目标已加载时跳过去，否则继续加载到目标所在的页；搜索时跳到第 N 个结果
+            if (search_state.active() || jump_state.target < posts.size() || posts.exhausted()) {
+                navigate([](ListView& view) { view.select(jump_state.target); }, offset);
+            } else {
+                posts.ensure_loaded(jump_state.target + 1);
+            }
+        }
         if (current_state == BLOG_VIEW) {
-            display_sidebar(posts, index,sidebar_offset, sidebar_win);
-            display_post(posts[index], offset, content_win);
-            // 绘制竖线
-            for (int y = 0; y < getmaxy(stdscr); y++) {
-                //mvwaddch(stdscr, y, 23, '|');  // 在第20列绘制 '|'
-                mvwaddch(stdscr, y, 23, ACS_VLINE);  // 使用 ncurses 的图形字符绘制线
-
+            // 视口接近已加载的末尾时，在后台加载下一页
+            if (!search_state.active()) {
+                posts.ensure_loaded(sidebar_view.top() + 2 * sidebar_view.height());
+            }
+            int selected = current_post();
+            if (selected >= 0 && posts.content_retry_due(posts.id(selected))) {
+                render_scheduler.invalidate(DIRTY_CONTENT);  // 重绘时重新请求失败的正文
             }
+            track_reading(posts, offset);
+            render_frame(posts, offset, layout);
+            // 当前文章请求之后再预取相邻的文章，顺序翻页时正文和折行都直接命中缓存
+            prefetcher.update(posts, post_layouts, sidebar_view.selected(), post_at_row, layout.content_width());
         }
-        handle_user_input(const_cast<std::vector<Post>&>(posts), index, offset,sidebar_offset , sidebar_win, content_win);
+        handle_user_input(posts, offset, layout);
         //handle_view_change_input(); // 处理视图切换输入
-        refresh();  // 刷新整个屏幕，包括侧边栏和内容窗口
     }
+}
+
+
+// 命令行：默认进入交互界面，--sidebar-width 设置侧边栏宽度（运行时可用 [ ] 调整）；
+// --export DIR 时不进入界面，把所有文章导出到 DIR
+void print_usage() {
+    std::cerr << "usage: miniBlogTUI [--sidebar-width N]\n"
+                 "       miniBlogTUI --export DIR [--format md|jsonl] [--concurrency N] [--page-size N] [--full]\n";
+}
 
-    delwin(sidebar_win);
-    delwin(content_win);
+bool parse_arguments(int argc, char** argv, int& sidebar_width, bool& export_mode, ExportOptions& options) {
+    export_mode = false;
+    bool export_options = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc && arg != "--full") {
+            return false;
+        }
+        export_options |= arg != "--export" && arg != "--sidebar-width";
+        if (arg == "--sidebar-width") {
+            sidebar_width = std::atoi(argv[++i]);
+            if (sidebar_width < MIN_SIDEBAR_WIDTH) return false;
+        } else if (arg == "--export") {
+            export_mode = true;
+            options.dir = argv[++i];
+        } else if (arg == "--format") {
+            std::string format = argv[++i];
+            if (format == "md") options.format = ExportFormat::MARKDOWN;
+            else if (format == "jsonl") options.format = ExportFormat::JSONL;
+            else return false;
+        } else if (arg == "--concurrency") {
+            options.concurrency = std::atoi(argv[++i]);
+        } else if (arg == "--page-size") {
+            options.page_size = std::atoi(argv[++i]);
+        } else if (arg == "--full") {
+            options.full = true;
+        } else {
+            return false;
+        }
+    }
+    // 导出选项只能与 --export 一起使用
+    return (export_mode || !export_options) && options.concurrency > 0 && options.page_size > 0;
 }
 
+// 无界面的导出：只用到 HTTP 客户端和作者目录，不读取令牌，也不启动订阅和发件箱
+int run_export(const ExportOptions& options) {
+    http_client();
+    author_directory();
+    // 按 --concurrency 放宽列表和正文请求的并发上限，速率限制不变
+    for (const char* endpoint : {"GET /posts", "GET /posts/{id}"}) {
+        RequestPolicy policy = http_client().scheduler().policy(endpoint);
+        policy.max_concurrency = std::max(policy.max_concurrency, options.concurrency);
+        http_client().scheduler().set_policy(endpoint, policy);
+    }
+    auto started = std::chrono::steady_clock::now();
+    ExportStats stats;
+    bool ok = export_posts(options, stats);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::cout << "Exported " << stats.written << " posts to " << options.dir << " (" << stats.unchanged
+              << " unchanged, " << stats.deleted << " deleted, " << stats.skipped << " skipped) in " << seconds << "s\n";
+    return ok ? 0 : 1;
+}
+
+
+int main(int argc, char** argv) {
+    int sidebar_width = DEFAULT_SIDEBAR_WIDTH;
+    bool export_mode;
+    ExportOptions export_options;
+    if (!parse_arguments(argc, argv, sidebar_width, export_mode, export_options)) {
+        print_usage();
+        return 2;
+    }
+
+    // tracer 最先创建、最后销毁，退出时所有线程的事件都已记录完。
+    // 设置 MINIBLOG_TRACE 时记录每个事件，退出时以 Chrome trace 格式写入该文件
+    tracer();
+    if (const char* trace_file = std::getenv("MINIBLOG_TRACE")) {
+        tracer().enable_trace_file(trace_file);
+    }
+    if (export_mode) {
+        return run_export(export_options);
+    }
+
+    // 按依赖顺序创建全局对象：后台线程用到的客户端和作者目录先创建，
+    // 退出时它们晚于 io_executor 和订阅线程销毁，后台线程不会用到已销毁的对象
+    http_client();
+    author_directory();
+    auth_session();
+    io_executor();
+    live_feed();
+    outbox();
+    reading_state();
+    // 设置 MINIBLOG_HTTP_TIMING 时把每个请求的耗时写入该文件
+    if (const char* timing_log = std::getenv("MINIBLOG_HTTP_TIMING")) {
+        http_client().set_timing_log(timing_log);
+    }
+
+    // 令牌只在这里读取一次，之后保存在内存中
+    auth_session().load();
+    auth_session().start();
+
+    // 上次退出或崩溃时没有发送的文章继续在后台发送
+    if (!outbox().start(post_request_with_token)) {
+        std::cerr << "Failed to open " << OUTBOX_FILE << "\n";
+    }
+
+    // 已读、书签和上次的位置；打不开文件时只保存在内存中
+    if (!reading_state().open()) {
+        std::cerr << "Failed to open " << READING_STATE_FILE << "\n";
+    }
 
-int main() {
-    // 假设 fetch_and_parse_posts 已经定义并返回一个 vector<Post>
-    std::vector<Post> posts = fetch_and_parse_posts();
+    // 先显示磁盘缓存中的文章，display_posts 再在后台向服务器重新验证
+    PostSource posts;
+    posts.load_cache(POST_CACHE_FILE);
 
     init_ncurses();     // 初始化 ncurses
 
-    display_posts(posts); // 显示帖子并处理滚动
+    display_posts(posts, sidebar_width); // 显示帖子并处理滚动
 
+    posts.save_cache(POST_CACHE_FILE);
     endwin();           // 结束 ncurses 模式
 
     return 0;
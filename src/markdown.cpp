@@ -0,0 +1,344 @@
+#include "markdown.h"
+
+#include <algorithm>
+
+namespace {
+
+// 标记字符本身不显示
+const uint8_t HIDDEN = 0x80;
+
+// 分隔线显示为 16 列的横线
+const std::string_view RULE = "────────────────";
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+bool is_punct(char c) {
+    return (c >= '!' && c <= '/') || (c >= ':' && c <= '@') || (c >= '[' && c <= '`') || (c >= '{' && c <= '~');
+}
+
+size_t run_length(std::string_view line, size_t pos) {
+    size_t end = pos;
+    while (end < line.size() && line[end] == line[pos]) ++end;
+    return end - pos;
+}
+
+// 行首最多 3 个空格的缩进
+size_t skip_indent(std::string_view line) {
+    size_t i = 0;
+    while (i < 3 && i < line.size() && line[i] == ' ') ++i;
+    return i;
+}
+
+bool blank(std::string_view text) {
+    return std::all_of(text.begin(), text.end(), is_space);
+}
+
+// 由至少 3 个相同的 - * _ 组成（可以夹空格）的分隔线
+bool is_rule(std::string_view line) {
+    size_t i = skip_indent(line);
+    if (i >= line.size() || (line[i] != '-' && line[i] != '*' && line[i] != '_')) {
+        return false;
+    }
+    char c = line[i];
+    int count = 0;
+    for (; i < line.size(); ++i) {
+        if (line[i] == c) {
+            ++count;
+        } else if (!is_space(line[i])) {
+            return false;
+        }
+    }
+    return count >= 3;
+}
+
+// 至少 3 个 ` 或 ~ 组成的代码块围栏，返回围栏的长度，end 为围栏之后的位置；不是围栏时返回 0
+size_t fence_run(std::string_view line, char& fence_char, size_t& end) {
+    size_t i = skip_indent(line);
+    if (i >= line.size() || (line[i] != '`' && line[i] != '~')) {
+        return 0;
+    }
+    size_t length = run_length(line, i);
+    end = i + length;
+    if (length < 3 || (line[i] == '`' && line.find('`', end) != std::string_view::npos)) {
+        return 0;  // ``` 后面的语言名中不能再有反引号
+    }
+    fence_char = line[i];
+    return length;
+}
+
+// 行内标记的处理：先为每个字节算出样式，再把样式相同的连续字节一次写入。
+// 强调按 CommonMark 的分隔符规则配对，没有配对的 * 和 _ 按原文显示
+class InlineRenderer {
+public:
+    void render(std::string_view line, uint8_t base, StyledText& out) {
+        if (line.find_first_of("\\`*_[") == std::string_view::npos) {
+            out.append(line, base);  // 大部分行没有行内标记
+            return;
+        }
+        styles_.assign(line.size(), STYLE_PLAIN);
+        delimiters_.clear();
+        brackets_.clear();
+        scan(line);
+        match_emphasis();
+
+        for (size_t i = 0; i < line.size();) {
+            if (styles_[i] & HIDDEN) {
+                ++i;
+                continue;
+            }
+            size_t j = i + 1;
+            while (j < line.size() && styles_[j] == styles_[i]) ++j;
+            out.append(line.substr(i, j - i), base | styles_[i]);
+            i = j;
+        }
+    }
+
+private:
+    struct Delimiter {
+        size_t pos;       // 尚未配对的部分的开始
+        size_t length;    // 尚未配对的字符数
+        size_t original;  // 原来的字符数
+        char c;
+        bool can_open;
+        bool can_close;
+    };
+
+    void mark(size_t begin, size_t end, uint8_t style) {
+        for (size_t i = begin; i < end; ++i) styles_[i] |= style;
+    }
+
+    // 转义、行内代码和链接在这里直接处理，* 和 _ 记录为分隔符
+    void scan(std::string_view line) {
+        size_t i = 0;
+        while (i < line.size()) {
+            char c = line[i];
+            if (c == '\\' && i + 1 < line.size() && is_punct(line[i + 1])) {
+                styles_[i] = HIDDEN;
+                i += 2;
+            } else if (c == '`') {
+                // 行内代码以同样长度的反引号结束，其中的内容不再解析
+                size_t length = run_length(line, i);
+                size_t close = i + length;
+                while ((close = line.find('`', close)) != std::string_view::npos && run_length(line, close) != length) {
+                    close += run_length(line, close);
+                }
+                if (close == std::string_view::npos) {
+                    i += length;
+                    continue;
+                }
+                mark(i, i + length, HIDDEN);
+                mark(i + length, close, STYLE_CODE);
+                mark(close, close + length, HIDDEN);
+                i = close + length;
+            } else if (c == '*' || c == '_') {
+                size_t length = run_length(line, i);
+                char before = i > 0 ? line[i - 1] : ' ';
+                char after = i + length < line.size() ? line[i + length] : ' ';
+                bool left = !is_space(after) && (!is_punct(after) || is_space(before) || is_punct(before));
+                bool right = !is_space(before) && (!is_punct(before) || is_space(after) || is_punct(after));
+                // 单词中间的 _ 不表示强调，如 snake_case
+                bool can_open = c == '*' ? left : left && (!right || is_punct(before));
+                bool can_close = c == '*' ? right : right && (!left || is_punct(after));
+                if (can_open || can_close) {
+                    delimiters_.push_back({i, length, length, c, can_open, can_close});
+                }
+                i += length;
+            } else if (c == '[') {
+                brackets_.push_back(i++);
+            } else if (c == ']' && !brackets_.empty() && i + 1 < line.size() && line[i + 1] == '(') {
+                size_t close = line.find(')', i + 2);
+                if (close == std::string_view::npos) {
+                    ++i;
+                    continue;
+                }
+                // 只显示链接文字；图片 ![说明](地址) 显示说明
+                size_t open = brackets_.back();
+                brackets_.clear();
+                if (open > 0 && line[open - 1] == '!') {
+                    styles_[open - 1] = HIDDEN;
+                }
+                styles_[open] = HIDDEN;
+                mark(open + 1, i, STYLE_LINK);
+                mark(i, close + 1, HIDDEN);
+                i = close + 1;
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    void match_emphasis() {
+        for (size_t k = 0; k < delimiters_.size(); ++k) {
+            Delimiter& closer = delimiters_[k];
+            if (!closer.can_close) {
+                continue;
+            }
+            while (closer.length > 0) {
+                // 向前找最近的、同一字符的可开始的分隔符
+                size_t j = k;
+                bool found = false;
+                while (j-- > 0) {
+                    const Delimiter& opener = delimiters_[j];
+                    if (opener.c != closer.c || !opener.can_open || opener.length == 0) {
+                        continue;
+                    }
+                    // 两边都既可开始又可结束时，长度之和是 3 的倍数的不配对，如 *a**b*
+                    if ((opener.can_close || closer.can_open) && (opener.original + closer.original) % 3 == 0 &&
+                        (opener.original % 3 != 0 || closer.original % 3 != 0)) {
+                        continue;
+                    }
+                    found = true;
+                    break;
+                }
+                if (!found) {
+                    break;
+                }
+
+                Delimiter& opener = delimiters_[j];
+                size_t use = opener.length >= 2 && closer.length >= 2 ? 2 : 1;
+                opener.length -= use;
+                size_t inner = opener.pos + opener.length + use;
+                mark(inner - use, inner, HIDDEN);
+                mark(inner, closer.pos, use == 2 ? STYLE_STRONG : STYLE_EMPHASIS);
+                mark(closer.pos, closer.pos + use, HIDDEN);
+                closer.pos += use;
+                closer.length -= use;
+                // 两者之间没有配对的分隔符不能再跨过这一对
+                for (size_t m = j + 1; m < k; ++m) delimiters_[m].length = 0;
+            }
+        }
+    }
+
+    std::vector<uint8_t> styles_;  // 每个字节的样式，HIDDEN 表示不显示
+    std::vector<Delimiter> delimiters_;
+    std::vector<size_t> brackets_;  // 还没有结束的 [
+};
+
+// 围栏代码块以外的一行
+void render_line(std::string_view line, InlineRenderer& renderer, StyledText& out) {
+    // 引用：每一层 > 显示为一条竖线
+    uint8_t base = STYLE_PLAIN;
+    size_t i = skip_indent(line);
+    if (i < line.size() && line[i] == '>') {
+        while (i < line.size() && line[i] == '>') {
+            out.append("│ ", STYLE_QUOTE | STYLE_MARKER);
+            ++i;
+            if (i < line.size() && line[i] == ' ') ++i;
+        }
+        base = STYLE_QUOTE;
+        line = line.substr(i);
+    }
+
+    if (is_rule(line)) {
+        out.append(RULE, base | STYLE_MARKER);
+        return;
+    }
+
+    // ATX 标题：1-6 个 #，后面是空格或行尾；结尾的 # 也去掉
+    i = skip_indent(line);
+    size_t level = i < line.size() && line[i] == '#' ? run_length(line, i) : 0;
+    if (level >= 1 && level <= 6 && (i + level == line.size() || is_space(line[i + level]))) {
+        std::string_view text = line.substr(i + level);
+        size_t end = text.find_last_not_of(" \t");
+        text = end == std::string_view::npos ? std::string_view() : text.substr(0, end + 1);
+        size_t hashes = text.find_last_not_of('#');
+        if (hashes == std::string_view::npos) {
+            text = {};
+        } else if (hashes + 1 < text.size() && is_space(text[hashes])) {
+            text = text.substr(0, hashes);
+        }
+        size_t begin = text.find_first_not_of(" \t");
+        end = text.find_last_not_of(" \t");
+        text = begin == std::string_view::npos ? std::string_view() : text.substr(begin, end - begin + 1);
+        renderer.render(text, base | STYLE_HEADING, out);
+        return;
+    }
+
+    // 列表：保留缩进，无序列表的符号显示为圆点，有序列表保留编号
+    size_t indent = 0;
+    while (indent < line.size() && line[indent] == ' ') ++indent;
+    size_t marker = indent;
+    if (marker < line.size() && (line[marker] == '-' || line[marker] == '*' || line[marker] == '+') &&
+        (marker + 1 == line.size() || is_space(line[marker + 1]))) {
+        out.append(line.substr(0, indent), base);
+        out.append("• ", base | STYLE_MARKER);
+        renderer.render(line.substr(std::min(marker + 2, line.size())), base, out);
+        return;
+    }
+    while (marker < line.size() && marker - indent < 9 && line[marker] >= '0' && line[marker] <= '9') ++marker;
+    if (marker > indent && marker < line.size() && (line[marker] == '.' || line[marker] == ')') &&
+        (marker + 1 == line.size() || is_space(line[marker + 1]))) {
+        out.append(line.substr(0, indent), base);
+        out.append(line.substr(indent, marker + 1 - indent), base | STYLE_MARKER);
+        renderer.render(line.substr(marker + 1), base, out);
+        return;
+    }
+
+    renderer.render(line, base, out);
+}
+
+}  // namespace
+
+void StyledText::append(std::string_view part, uint8_t style) {
+    if (part.empty()) {
+        return;
+    }
+    if (runs.empty()) {
+        runs.push_back({0, style});  // 第一段总是从 0 开始，前面的空行也属于它
+    } else if (runs.back().style != style) {
+        runs.push_back({static_cast<uint32_t>(text.size()), style});
+    }
+    text.append(part);
+}
+
+size_t StyledText::run_at(size_t offset) const {
+    auto it = std::upper_bound(runs.begin(), runs.end(), offset,
+                               [](size_t value, const StyleRun& run) { return value < run.offset; });
+    return it == runs.begin() ? 0 : static_cast<size_t>(it - runs.begin()) - 1;
+}
+
+size_t StyledText::run_end(size_t index) const {
+    return index + 1 < runs.size() ? runs[index + 1].offset : text.size();
+}
+
+StyledText render_markdown(std::string_view source) {
+    StyledText out;
+    out.text.reserve(source.size());
+    InlineRenderer renderer;
+    size_t fence = 0;  // 当前代码块的围栏长度，不在代码块中时为 0
+    char fence_char = 0;
+
+    size_t pos = 0;
+    while (pos < source.size()) {
+        size_t newline = source.find('\n', pos);
+        size_t end = newline == std::string_view::npos ? source.size() : newline;
+        std::string_view line = source.substr(pos, end - pos);
+        pos = end + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        char c = 0;
+        size_t run_end = 0;
+        size_t length = fence_run(line, c, run_end);
+        if (fence > 0) {
+            if (length >= fence && c == fence_char && blank(line.substr(run_end))) {
+                fence = 0;  // 围栏所在的行不显示
+                continue;
+            }
+            out.append(line, STYLE_CODE);  // 代码块中的内容原样显示
+        } else if (length > 0) {
+            fence = length;
+            fence_char = c;
+            continue;
+        } else {
+            render_line(line, renderer, out);
+        }
+        if (newline != std::string_view::npos) {
+            out.text.push_back('\n');
+        }
+    }
+    return out;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 文字的样式，可以组合（如粗体中的行内代码）
+enum TextStyle : uint8_t {
+    STYLE_PLAIN = 0,
+    STYLE_STRONG = 1 << 0,    // **粗体**
+    STYLE_EMPHASIS = 1 << 1,  // *斜体*
+    STYLE_CODE = 1 << 2,      // `行内代码` 和代码块
+    STYLE_LINK = 1 << 3,      // [链接文字](地址)，只显示文字
+    STYLE_HEADING = 1 << 4,   // # 标题
+    STYLE_QUOTE = 1 << 5,     // > 引用
+    STYLE_MARKER = 1 << 6,    // 列表符号和分隔线
+};
+
+// 从 offset 开始直到下一段开始的文字使用 style
+struct StyleRun {
+    uint32_t offset;
+    uint8_t style;
+};
+
+// 渲染后的正文：去掉 Markdown 标记后的文字，以及覆盖全部文字的样式段。
+// 文字按行排列，可以直接交给 layout_text 折行；样式段按 offset 递增，第一段从 0 开始
+struct StyledText {
+    std::string text;
+    std::vector<StyleRun> runs;
+
+    void append(std::string_view part, uint8_t style);
+    // 包含 offset 处文字的样式段的下标，runs 为空时返回 0
+    size_t run_at(size_t offset) const;
+    // 第 index 段的结束位置
+    size_t run_end(size_t index) const;
+};
+
+// 把 Markdown 正文转换为带样式的文字。逐行处理，支持 ATX 标题、围栏代码块、引用、
+// 有序/无序列表、分隔线，以及行内的粗体、斜体、行内代码、链接和反斜杠转义；
+// 不认识的写法按原文显示。段落内的换行保留，不合并为一行
+StyledText render_markdown(std::string_view source);
@@ -0,0 +1,324 @@
+#include "outbox.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <random>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const uint8_t RECORD_ENQUEUE = 1;
+const uint8_t RECORD_DONE = 2;
+const uint8_t RESULT_SENT = 1;
+const uint8_t RESULT_REJECTED = 2;
+const std::chrono::milliseconds MAX_BACKOFF(5 * 60 * 1000);
+
+uint32_t fnv1a(std::string_view data, uint32_t hash = 2166136261u) {
+    for (unsigned char c : data) {
+        hash = (hash ^ c) * 16777619u;
+    }
+    return hash;
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void put_string(std::string& out, std::string_view value) {
+    put<uint32_t>(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+template <typename T>
+bool get(std::string_view& in, T& value) {
+    if (in.size() < sizeof(T)) return false;
+    std::memcpy(&value, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return true;
+}
+
+bool get_string(std::string_view& in, std::string& value) {
+    uint32_t length;
+    if (!get(in, length) || in.size() < length) return false;
+    value.assign(in.data(), length);
+    in.remove_prefix(length);
+    return true;
+}
+
+// 128 位随机幂等键
+std::string make_idempotency_key() {
+    static const char hex[] = "0123456789abcdef";
+    std::random_device random;
+    std::string key;
+    for (int i = 0; i < 32; ++i) {
+        key.push_back(hex[random() & 15]);
+    }
+    return key;
+}
+
+bool write_all(int fd, const iovec* parts, int count) {
+    std::vector<iovec> rest(parts, parts + count);
+    size_t index = 0;
+    while (index < rest.size()) {
+        ssize_t n = writev(fd, rest.data() + index, static_cast<int>(rest.size() - index));
+        if (n < 0) return false;
+        while (index < rest.size() && (n > 0 || rest[index].iov_len == 0)) {  // 同时跳过空的部分
+            size_t used = std::min(static_cast<size_t>(n), rest[index].iov_len);
+            rest[index].iov_base = static_cast<char*>(rest[index].iov_base) + used;
+            rest[index].iov_len -= used;
+            n -= used;
+            if (rest[index].iov_len == 0) ++index;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+Outbox::Outbox(std::string path, size_t batch_size) : path_(std::move(path)), batch_size_(std::max<size_t>(batch_size, 1)) {}
+
+Outbox::~Outbox() {
+    stop();
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool Outbox::start(Sender sender) {
+    if (thread_.joinable()) {
+        return true;
+    }
+    sender_ = std::move(sender);
+    if (!open_journal()) {
+        return false;
+    }
+    stopping_ = false;
+    thread_ = std::thread(&Outbox::run, this);
+    return true;
+}
+
+void Outbox::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+// 重放日志：入队的记录加入待发送队列，完成的记录把它移出；
+// 遇到不完整或校验失败的记录就截断到它之前
+bool Outbox::open_journal() {
+    struct stat st;
+    bool created = stat(path_.c_str(), &st) != 0;
+    fd_ = open(path_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd_ < 0) {
+        return false;
+    }
+    if (created) {
+        // 新建的文件要同步所在的目录，否则崩溃后目录项可能丢失
+        size_t slash = path_.rfind('/');
+        int dir = open(slash == std::string::npos ? "." : path_.substr(0, slash + 1).c_str(), O_RDONLY | O_CLOEXEC);
+        if (dir >= 0) {
+            fsync(dir);
+            close(dir);
+        }
+    }
+
+    MappedFile journal;
+    uint64_t valid = 0;
+    if (journal.open(path_)) {
+        std::string_view data = journal.data();
+        while (data.size() - valid >= 2 * sizeof(uint32_t)) {
+            std::string_view in = data.substr(valid);
+            uint32_t length, checksum;
+            get(in, length);
+            get(in, checksum);
+            if (in.size() < length || fnv1a(in.substr(0, length)) != checksum) {
+                break;
+            }
+            std::string_view payload = in.substr(0, length);
+            uint64_t payload_offset = valid + 2 * sizeof(uint32_t);
+            uint8_t type;
+            uint64_t seq;
+            if (!get(payload, type) || !get(payload, seq)) {
+                break;
+            }
+            if (type == RECORD_ENQUEUE) {
+                Entry entry{seq, {}, {}, 0, 0};
+                if (!get_string(payload, entry.key) || !get_string(payload, entry.title)) {
+                    break;
+                }
+                entry.content_length = payload.size();
+                entry.content_offset = payload_offset + (length - payload.size());
+                pending_.push_back(std::move(entry));
+            } else if (type == RECORD_DONE) {
+                pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                                              [seq](const Entry& entry) { return entry.seq == seq; }),
+                               pending_.end());
+            }
+            next_seq_ = std::max(next_seq_, seq + 1);
+            valid += 2 * sizeof(uint32_t) + length;
+        }
+    }
+
+    // 没有待发送的文章时清空日志，否则只截掉损坏的尾部
+    file_size_ = pending_.empty() ? 0 : valid;
+    if (ftruncate(fd_, file_size_) != 0 || fsync(fd_) != 0) {
+        return false;
+    }
+    status_.pending = pending_.size();
+    next_attempt_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool Outbox::write_record_locked(const std::string& head, std::string_view content) {
+    std::string header;
+    put<uint32_t>(header, static_cast<uint32_t>(head.size() + content.size()));
+    put<uint32_t>(header, fnv1a(content, fnv1a(head)));
+    iovec parts[] = {{const_cast<char*>(header.data()), header.size()},
+                     {const_cast<char*>(head.data()), head.size()},
+                     {const_cast<char*>(content.data()), content.size()}};
+    if (!write_all(fd_, parts, 3)) {
+        // 撤销写了一半的记录；撤销也失败时，下次打开日志会把它截掉
+        int ignored = ftruncate(fd_, file_size_);
+        (void)ignored;
+        return false;
+    }
+    file_size_ += header.size() + head.size() + content.size();
+    return true;
+}
+
+bool Outbox::enqueue(const std::string& title, const std::string& content_path) {
+    MappedFile content;
+    if (!content.open(content_path)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0) {
+        return false;
+    }
+    Entry entry{next_seq_, make_idempotency_key(), title, 0, content.data().size()};
+    std::string head;
+    put<uint8_t>(head, RECORD_ENQUEUE);
+    put<uint64_t>(head, entry.seq);
+    put_string(head, entry.key);
+    put_string(head, entry.title);
+    entry.content_offset = file_size_ + 2 * sizeof(uint32_t) + head.size();
+    if (!write_record_locked(head, content.data()) || fsync(fd_) != 0) {
+        return false;
+    }
+
+    ++next_seq_;
+    pending_.push_back(std::move(entry));
+    status_.pending = pending_.size();
+    cv_.notify_all();
+    return true;
+}
+
+void Outbox::retry_now() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    next_attempt_ = std::chrono::steady_clock::now();
+    cv_.notify_all();
+}
+
+OutboxStatus Outbox::status() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    OutboxStatus status = status_;
+    if (!status.sending && !pending_.empty()) {
+        auto wait = next_attempt_ - std::chrono::steady_clock::now();
+        status.retry_in_seconds = std::max(0, static_cast<int>(std::chrono::ceil<std::chrono::seconds>(wait).count()));
+    }
+    return status;
+}
+
+void Outbox::run() {
+    while (true) {
+        std::vector<Entry> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stopping_ && (pending_.empty() || std::chrono::steady_clock::now() < next_attempt_)) {
+                if (pending_.empty()) {
+                    cv_.wait(lock);
+                } else {
+                    cv_.wait_until(lock, next_attempt_);
+                }
+            }
+            if (stopping_) {
+                return;
+            }
+            // 积压较多时一次取出一批，连续发送后一次写入完成标记
+            size_t count = std::min(batch_size_, pending_.size());
+            batch.assign(pending_.begin(), pending_.begin() + count);
+            status_.sending = true;
+        }
+
+        std::vector<std::pair<uint64_t, uint8_t>> finished;
+        std::string error;
+        {
+            MappedFile journal;  // 映射当前的日志，发送完这一批后解除映射
+            bool mapped = journal.open(path_);
+            for (const auto& entry : batch) {
+                if (!mapped || stopping_) {
+                    error = mapped ? "" : "cannot read outbox";
+                    break;
+                }
+                long status = sender_(entry.title, journal, entry.content_offset, entry.content_length, entry.key);
+                if (status == 200 || status == 201) {
+                    finished.emplace_back(entry.seq, RESULT_SENT);
+                } else if (status == 400 || status == 413 || status == 422) {
+                    finished.emplace_back(entry.seq, RESULT_REJECTED);  // 内容本身有问题，重试也不会成功
+                    error = "rejected (HTTP " + std::to_string(status) + ")";
+                } else {
+                    error = status == 0 ? "network error" : "HTTP " + std::to_string(status);
+                    break;
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [seq, result] : finished) {
+            std::string head;
+            put<uint8_t>(head, RECORD_DONE);
+            put<uint64_t>(head, seq);
+            put<uint8_t>(head, result);
+            write_record_locked(head, {});
+            if (result == RESULT_REJECTED) {
+                ++status_.rejected;
+            }
+        }
+        if (!finished.empty()) {
+            fsync(fd_);
+            pending_.erase(pending_.begin(), pending_.begin() + finished.size());
+        }
+        if (pending_.empty() && ftruncate(fd_, 0) == 0) {
+            file_size_ = 0;  // 全部发送完，日志从头开始
+        }
+
+        if (finished.size() < batch.size() && !stopping_) {
+            // 失败：指数退避，加入随机抖动，避免多个客户端同时重试
+            static std::minstd_rand jitter(std::random_device{}());
+            auto delay = backoff_ + std::chrono::milliseconds(jitter() % (backoff_.count() / 2 + 1));
+            next_attempt_ = std::chrono::steady_clock::now() + delay;
+            backoff_ = std::min(backoff_ * 2, MAX_BACKOFF);
+        } else {
+            backoff_ = std::chrono::milliseconds(1000);
+        }
+        status_.sending = false;
+        status_.pending = pending_.size();
+        status_.last_error = error;
+    }
+}
+
+Outbox& outbox() {
+    static Outbox box;
+    return box;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "post_upload.h"
+
+// 待发布文章的日志文件，与 token 一样放在当前目录
+const std::string OUTBOX_FILE = "outbox.journal";
+
+// 发件箱的状态，显示在状态栏
+struct OutboxStatus {
+    size_t pending = 0;         // 尚未发布成功的文章数
+    bool sending = false;       // 正在发送
+    int retry_in_seconds = 0;   // 上一次失败后，距离下一次重试的秒数
+    size_t rejected = 0;        // 被服务器拒绝（不会重试）的文章数
+    std::string last_error;
+
+    bool operator==(const OutboxStatus& other) const {
+        return pending == other.pending && sending == other.sending && retry_in_seconds == other.retry_in_seconds &&
+               rejected == other.rejected && last_error == other.last_error;
+    }
+    bool operator!=(const OutboxStatus& other) const { return !(*this == other); }
+};
+
+// 发件箱：F2 发布的文章先追加到只追加的日志文件并 fsync，立即返回；
+// 后台线程按顺序发送，失败时指数退避后重试，积压较多时一批连续发送并一次 fsync 完成标记。
+// 每篇文章带有创建时生成的幂等键，崩溃后重发不会重复发布。
+// 日志记录：u32 长度 | u32 校验和 | 载荷，载荷为
+//   入队: u8 1 | u64 序号 | 字符串 幂等键 | 字符串 标题 | 正文（直到记录末尾）
+//   完成: u8 2 | u64 序号 | u8 结果
+// 字符串为 u32 长度 + 字节。末尾不完整或校验失败的记录（写入时崩溃）在打开时被截掉
+class Outbox {
+public:
+    // 发送一篇文章，正文是 file 中 [offset, offset + length) 的部分；返回 HTTP 状态码，网络错误时返回 0
+    using Sender = std::function<long(const std::string& title, MappedFile& file, size_t offset, size_t length,
+                                      const std::string& idempotency_key)>;
+
+    explicit Outbox(std::string path = OUTBOX_FILE, size_t batch_size = 16);
+    ~Outbox();
+
+    Outbox(const Outbox&) = delete;
+    Outbox& operator=(const Outbox&) = delete;
+
+    // 打开日志、恢复上次未发送的文章并启动后台发送线程
+    bool start(Sender sender);
+    void stop();
+    bool stopping() const { return stopping_; }
+
+    // 把 content_path 中的正文和标题追加到日志并 fsync；文件为空或写入失败时返回 false
+    bool enqueue(const std::string& title, const std::string& content_path);
+
+    // 跳过退避等待，立即重试
+    void retry_now();
+
+    OutboxStatus status() const;
+
+private:
+    struct Entry {
+        uint64_t seq;
+        std::string key;
+        std::string title;
+        uint64_t content_offset;  // 正文在日志文件中的位置
+        uint64_t content_length;
+    };
+
+    bool open_journal();
+    bool write_record_locked(const std::string& head, std::string_view content);
+    void run();
+
+    std::string path_;
+    size_t batch_size_;
+    Sender sender_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+
+    int fd_ = -1;
+    uint64_t file_size_ = 0;
+    uint64_t next_seq_ = 1;
+    std::deque<Entry> pending_;
+    OutboxStatus status_;
+    std::chrono::steady_clock::time_point next_attempt_;
+    std::chrono::milliseconds backoff_{1000};
+};
+
+// 全局发件箱
+Outbox& outbox();
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+struct Post {
+    std::string title;
+    std::string content;      // 列表中的摘要不保存正文，正文由 PostSource 的缓存管理
+    int id;
+    std::string published;
+    int author_id;
+    std::string author_name;  // 新增字段
+};
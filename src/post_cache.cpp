@@ -0,0 +1,238 @@
+#include "post_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 文件格式（本机字节序，只在本地使用）:
+//   头部:   "MBTC" | u32 版本 | u32 标志 | u32 文章数 | u32 作者数 | 字符串 etag | 字符串 last_modified
+//   作者:   i32 author_id | 字符串 用户名，每个作者只保存一次
+//   摘要:   i32 id | i32 author_id | i64 发布时间 | u64 正文偏移 | u64 正文长度 | 字符串 title
+//   正文:   所有正文依次排列，由摘要中的偏移和长度定位
+// 字符串为 u32 长度 + 字节。没有正文的文章偏移为 0
+namespace {
+
+const char MAGIC[4] = {'M', 'B', 'T', 'C'};
+const uint32_t VERSION = 2;
+const uint32_t FLAG_EXHAUSTED = 1;
+
+// 带边界检查的读取器，任何越界都会使整个缓存无效
+class Reader {
+public:
+    Reader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    bool read(T& value) {
+        if (size_ - pos_ < sizeof(T)) return false;
+        std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string& value) {
+        std::string_view view;
+        if (!read(view)) return false;
+        value.assign(view);
+        return true;
+    }
+
+    // 直接指向映射内存，不复制
+    bool read(std::string_view& value) {
+        uint32_t length;
+        if (!read(length) || size_ - pos_ < length) return false;
+        value = std::string_view(data_ + pos_, length);
+        pos_ += length;
+        return true;
+    }
+
+    bool skip(size_t length) {
+        if (size_ - pos_ < length) return false;
+        pos_ += length;
+        return true;
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+template <typename T>
+void write_value(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void write_string(std::ofstream& out, std::string_view value) {
+    write_value<uint32_t>(out, static_cast<uint32_t>(value.size()));
+    out.write(value.data(), value.size());
+}
+
+size_t string_size(std::string_view value) {
+    return sizeof(uint32_t) + value.size();
+}
+
+}  // namespace
+
+PostDiskCache::~PostDiskCache() {
+    unmap();
+}
+
+bool PostDiskCache::load(const std::string& path, PostStore& posts, CacheValidators& validators, bool& exhausted) {
+    unmap();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;  // 第一次运行，没有缓存
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // 映射建立后可以关闭文件
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const char*>(mapped);
+    size_ = st.st_size;
+
+    Reader reader(data_, size_);
+    char magic[4];
+    uint32_t version, flags, count, author_count;
+    CacheValidators loaded_validators;
+    if (size_ < sizeof(magic) || std::memcmp(data_, MAGIC, sizeof(magic)) != 0 || !reader.skip(sizeof(magic)) ||
+        !reader.read(version) || version != VERSION || !reader.read(flags) || !reader.read(count) ||
+        !reader.read(author_count) || !reader.read(loaded_validators.etag) ||
+        !reader.read(loaded_validators.last_modified)) {
+        unmap();
+        return false;
+    }
+
+    std::unordered_map<int, std::string_view> authors;
+    for (uint32_t i = 0; i < author_count; ++i) {
+        int32_t author_id;
+        std::string_view name;
+        if (!reader.read(author_id) || !reader.read(name)) {
+            unmap();
+            return false;
+        }
+        authors[author_id] = name;
+    }
+
+    PostStore loaded;
+    loaded.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        int32_t id, author_id;
+        int64_t published;
+        uint64_t content_offset, content_length;
+        std::string_view title;
+        if (!reader.read(id) || !reader.read(author_id) || !reader.read(published) || !reader.read(content_offset) ||
+            !reader.read(content_length) || !reader.read(title) || content_offset > size_ ||
+            content_length > size_ - content_offset) {
+            unmap();
+            return false;
+        }
+        if (content_offset != 0) {
+            content_index_[id] = {content_offset, content_length};
+        }
+        auto author = authors.find(author_id);
+        loaded.push_back(id, author_id, title, published, author != authors.end() ? author->second : "");
+    }
+
+    posts = std::move(loaded);
+    validators = std::move(loaded_validators);
+    exhausted = flags & FLAG_EXHAUSTED;
+    return true;
+}
+
+bool PostDiskCache::content(int post_id, std::string_view& content) const {
+    auto it = content_index_.find(post_id);
+    if (it == content_index_.end()) {
+        return false;
+    }
+    content = std::string_view(data_ + it->second.first, it->second.second);
+    return true;
+}
+
+void PostDiskCache::forget_content(int post_id) {
+    content_index_.erase(post_id);
+}
+
+bool PostDiskCache::save(const std::string& path, const PostStore& posts, const ContentLookup& lookup,
+                         const CacheValidators& validators, bool exhausted) {
+    // 每个作者只写一次用户名
+    std::vector<std::pair<int, std::string_view>> authors;
+    std::unordered_map<int, size_t> author_index;
+    for (size_t i = 0; i < posts.size(); ++i) {
+        if (author_index.emplace(posts.author_id(i), authors.size()).second) {
+            authors.emplace_back(posts.author_id(i), posts.author_name(i));
+        }
+    }
+
+    // 先计算摘要部分的大小，才能确定每篇正文的偏移
+    uint64_t offset = sizeof(MAGIC) + 4 * sizeof(uint32_t) + string_size(validators.etag) +
+                      string_size(validators.last_modified);
+    for (const auto& author : authors) {
+        offset += sizeof(int32_t) + string_size(author.second);
+    }
+    for (size_t i = 0; i < posts.size(); ++i) {
+        offset += 2 * sizeof(int32_t) + sizeof(int64_t) + 2 * sizeof(uint64_t) + string_size(posts.title(i));
+    }
+
+    std::string temp_path = path + ".tmp";
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    out.write(MAGIC, sizeof(MAGIC));
+    write_value<uint32_t>(out, VERSION);
+    write_value<uint32_t>(out, exhausted ? FLAG_EXHAUSTED : 0);
+    write_value<uint32_t>(out, static_cast<uint32_t>(posts.size()));
+    write_value<uint32_t>(out, static_cast<uint32_t>(authors.size()));
+    write_string(out, validators.etag);
+    write_string(out, validators.last_modified);
+    for (const auto& author : authors) {
+        write_value<int32_t>(out, author.first);
+        write_string(out, author.second);
+    }
+
+    std::vector<std::string_view> contents(posts.size());
+    for (size_t i = 0; i < posts.size(); ++i) {
+        bool has_content = lookup(posts.id(i), contents[i]);
+        write_value<int32_t>(out, posts.id(i));
+        write_value<int32_t>(out, posts.author_id(i));
+        write_value<int64_t>(out, posts.published(i));
+        write_value<uint64_t>(out, has_content ? offset : 0);
+        write_value<uint64_t>(out, has_content ? contents[i].size() : 0);
+        write_string(out, posts.title(i));
+        if (has_content) {
+            offset += contents[i].size();
+        }
+    }
+    for (const auto& content : contents) {
+        out.write(content.data(), content.size());
+    }
+
+    out.close();
+    if (!out) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    // 改名是原子的；已经映射的旧文件在解除映射前仍然有效
+    return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+void PostDiskCache::unmap() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+    content_index_.clear();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "post_store.h"
+
+// 默认的缓存文件，与 token 一样放在当前目录
+const std::string POST_CACHE_FILE = "posts.cache";
+
+// 条件请求使用的校验信息，来自上一次响应的 ETag / Last-Modified
+struct CacheValidators {
+    std::string etag;
+    std::string last_modified;
+    bool not_modified = false;  // 最近一次请求返回了 304
+};
+
+// 磁盘上的文章缓存：紧凑的二进制文件，前半部分是文章摘要，后半部分是正文。
+// 加载时通过 mmap 映射整个文件，只解析摘要；正文按文章 id 直接从映射中读取
+class PostDiskCache {
+public:
+    PostDiskCache() = default;
+    ~PostDiskCache();
+
+    PostDiskCache(const PostDiskCache&) = delete;
+    PostDiskCache& operator=(const PostDiskCache&) = delete;
+
+    // 加载缓存文件，文件不存在或格式不正确时返回 false
+    bool load(const std::string& path, PostStore& posts, CacheValidators& validators, bool& exhausted);
+
+    // 返回缓存中的正文（指向映射内存），没有时返回 false
+    bool content(int post_id, std::string_view& content) const;
+
+    // 文章已在服务器上修改，不再使用缓存中的正文
+    void forget_content(int post_id);
+
+    // 写入缓存文件：先写临时文件再改名，写入过程中崩溃不会破坏旧缓存
+    using ContentLookup = std::function<bool(int post_id, std::string_view& content)>;
+    static bool save(const std::string& path, const PostStore& posts, const ContentLookup& lookup,
+                     const CacheValidators& validators, bool exhausted);
+
+private:
+    void unmap();
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::unordered_map<int, std::pair<uint64_t, uint64_t>> content_index_;  // id -> (偏移, 长度)
+};
@@ -0,0 +1,194 @@
+#include "post_parser.h"
+
+#include <nlohmann/json.hpp>
+#include <utility>
+
+namespace {
+
+using json = nlohmann::json;
+
+// 只识别 “对象数组” 这一种结构，其余嵌套的值一律跳过
+class PostSaxHandler : public nlohmann::json_sax<json> {
+public:
+    PostSaxHandler(std::vector<Post>& posts, std::string& error) : posts_(posts), error_(error) {}
+
+    bool null() override { return scalar(); }
+    bool boolean(bool) override { return scalar(); }
+    bool number_integer(number_integer_t value) override { return number(static_cast<long long>(value)); }
+    bool number_unsigned(number_unsigned_t value) override { return number(static_cast<long long>(value)); }
+    bool number_float(number_float_t, const string_t&) override { return scalar(); }
+    bool binary(binary_t&) override { return scalar(); }
+
+    bool string(string_t& value) override {
+        if (depth_ != 2) return scalar();
+        switch (field_) {
+            case Field::TITLE: post_.title = std::move(value); break;
+            case Field::CONTENT: post_.content = std::move(value); break;
+            case Field::PUBLISHED: post_.published = std::move(value); break;
+            case Field::ID:
+            case Field::AUTHOR_ID: return fail("expected a number for id / author_id");
+            case Field::OTHER: break;
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        if (depth_ == 0) return fail("expected an array of posts");
+        if (depth_ == 1) {
+            post_ = Post{};
+            has_id_ = has_author_id_ = false;
+        }
+        ++depth_;
+        return true;
+    }
+
+    bool key(string_t& name) override {
+        if (depth_ != 2) return true;
+        if (name == "title") field_ = Field::TITLE;
+        else if (name == "content") field_ = Field::CONTENT;
+        else if (name == "id") field_ = Field::ID;
+        else if (name == "published") field_ = Field::PUBLISHED;
+        else if (name == "author_id") field_ = Field::AUTHOR_ID;
+        else field_ = Field::OTHER;
+        return true;
+    }
+
+    bool end_object() override {
+        if (--depth_ == 1) {
+            if (!has_id_ || !has_author_id_) return fail("post without id or author_id");
+            posts_.push_back(std::move(post_));
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (depth_ == 1) return fail("expected an array of posts");
+        ++depth_;
+        return true;
+    }
+
+    bool end_array() override {
+        --depth_;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        return fail(ex.what());
+    }
+
+private:
+    enum class Field { TITLE, CONTENT, ID, PUBLISHED, AUTHOR_ID, OTHER };
+
+    // 非字符串、非数字的标量：顶层出现或出现在数组元素位置都不合法
+    bool scalar() {
+        if (depth_ <= 1) return fail("expected an array of posts");
+        return true;
+    }
+
+    bool number(long long value) {
+        if (depth_ != 2) return scalar();
+        if (field_ == Field::ID) {
+            post_.id = static_cast<int>(value);
+            has_id_ = true;
+        } else if (field_ == Field::AUTHOR_ID) {
+            post_.author_id = static_cast<int>(value);
+            has_author_id_ = true;
+        }
+        return true;
+    }
+
+    bool fail(const std::string& message) {
+        if (error_.empty()) error_ = message;
+        return false;
+    }
+
+    std::vector<Post>& posts_;
+    std::string& error_;
+    int depth_ = 0;  // 0: 顶层，1: 数组内，2: 文章对象内，更深为跳过的嵌套值
+    Field field_ = Field::OTHER;
+    Post post_{};
+    bool has_id_ = false;
+    bool has_author_id_ = false;
+};
+
+}  // namespace
+
+bool parse_posts(std::istream& in, std::vector<Post>& posts, std::string& error) {
+    PostSaxHandler handler(posts, error);
+    return json::sax_parse(in, &handler);
+}
+
+bool parse_posts(std::string_view text, std::vector<Post>& posts, std::string& error) {
+    PostSaxHandler handler(posts, error);
+    return json::sax_parse(text.begin(), text.end(), &handler);
+}
+
+
+StreamingPostParser::StreamingPostParser(std::vector<Post>& posts, size_t max_buffered_bytes)
+    : buffer_(max_buffered_bytes), posts_(posts) {
+    thread_ = std::thread([this]() {
+        std::istream in(&buffer_);
+        ok_ = parse_posts(in, posts_, error_);
+        buffer_.abandon();  // 解析结束后不再需要后续数据
+    });
+}
+
+StreamingPostParser::~StreamingPostParser() {
+    finish();
+}
+
+bool StreamingPostParser::feed(std::string_view chunk) {
+    return buffer_.push(chunk);
+}
+
+bool StreamingPostParser::finish() {
+    if (!finished_) {
+        finished_ = true;
+        buffer_.close();
+        thread_.join();
+    }
+    return ok_;
+}
+
+bool StreamingPostParser::ChunkBuffer::push(std::string_view chunk) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return abandoned_ || queued_bytes_ < max_bytes_; });
+    if (abandoned_) {
+        return false;
+    }
+    if (chunk.empty()) {
+        return true;
+    }
+    chunks_.emplace_back(chunk);
+    queued_bytes_ += chunk.size();
+    cv_.notify_all();
+    return true;
+}
+
+void StreamingPostParser::ChunkBuffer::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    cv_.notify_all();
+}
+
+void StreamingPostParser::ChunkBuffer::abandon() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    abandoned_ = true;
+    chunks_.clear();
+    queued_bytes_ = 0;
+    cv_.notify_all();
+}
+
+StreamingPostParser::ChunkBuffer::int_type StreamingPostParser::ChunkBuffer::underflow() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return closed_ || !chunks_.empty(); });
+    if (chunks_.empty()) {
+        return traits_type::eof();
+    }
+    current_ = std::move(chunks_.front());
+    chunks_.pop_front();
+    queued_bytes_ -= current_.size();
+    cv_.notify_all();
+    setg(current_.data(), current_.data(), current_.data() + current_.size());
+    return traits_type::to_int_type(*gptr());
+}
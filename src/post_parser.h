@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "post.h"
+
+// 用 SAX 方式把 /posts 返回的 JSON 数组直接解析成 Post，字符串直接移动到字段中，
+// 不构造 nlohmann::json DOM。格式不正确或缺少 id / author_id 时返回 false
+bool parse_posts(std::istream& in, std::vector<Post>& posts, std::string& error);
+bool parse_posts(std::string_view text, std::vector<Post>& posts, std::string& error);
+
+// 边下载边解析：网络线程通过 feed() 送入收到的数据块，解析在单独的线程中进行。
+// 缓冲的数据超过上限时 feed() 会阻塞，从而限制下载速度，内存占用保持在上限以内
+class StreamingPostParser {
+public:
+    explicit StreamingPostParser(std::vector<Post>& posts, size_t max_buffered_bytes = 1 << 20);
+    ~StreamingPostParser();
+
+    StreamingPostParser(const StreamingPostParser&) = delete;
+    StreamingPostParser& operator=(const StreamingPostParser&) = delete;
+
+    // 送入一块数据；解析已经失败时返回 false，可以据此中止下载
+    bool feed(std::string_view chunk);
+
+    // 数据已全部送入，等待解析完成并返回是否成功
+    bool finish();
+
+    const std::string& error() const { return error_; }
+
+private:
+    // 由数据块队列提供输入的 streambuf，队列为空时等待新的数据
+    class ChunkBuffer : public std::streambuf {
+    public:
+        explicit ChunkBuffer(size_t max_bytes) : max_bytes_(max_bytes) {}
+        bool push(std::string_view chunk);
+        void close();    // 生产者：没有更多数据
+        void abandon();  // 消费者：不再读取，唤醒并拒绝生产者
+
+    protected:
+        int_type underflow() override;
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<std::string> chunks_;
+        std::string current_;
+        size_t queued_bytes_ = 0;
+        size_t max_bytes_;
+        bool closed_ = false;
+        bool abandoned_ = false;
+    };
+
+    ChunkBuffer buffer_;
+    std::vector<Post>& posts_;
+    std::string error_;
+    bool ok_ = false;
+    bool finished_ = false;
+    std::thread thread_;
+};
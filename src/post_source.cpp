@@ -0,0 +1,588 @@
+#include "post_source.h"
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <tuple>
+
+#include "author_directory.h"
+#include "http_client.h"
+#include "io_executor.h"
+#include "post_parser.h"
+#include "trace.h"
+
+namespace {
+
+const std::chrono::seconds MIN_RETRY(1);
+const std::chrono::seconds MAX_RETRY(60);
+
+// 在后台线程中切分随分页带回的正文，UI 线程只合并倒排列表
+std::vector<std::vector<std::string>> tokenize_contents(const std::vector<Post>& page) {
+    std::vector<std::vector<std::string>> tokens(page.size());
+    for (size_t i = 0; i < page.size(); ++i) {
+        if (!page[i].content.empty()) {
+            tokens[i] = tokenize(page[i].content);
+        }
+    }
+    return tokens;
+}
+
+bool fetch_and_parse(int skip, int limit, std::vector<Post>& posts, CacheValidators* validators, std::string* error) {
+    TRACE_SCOPE("fetch_posts");  // 流式解析与下载同时进行，包含两者
+    // 条件请求：内容未变化时服务器只返回 304
+    cpr::Header header;
+    if (validators) {
+        validators->not_modified = false;
+        if (!validators->etag.empty()) header["If-None-Match"] = validators->etag;
+        if (!validators->last_modified.empty()) header["If-Modified-Since"] = validators->last_modified;
+    }
+
+    // 响应体边下载边解析，直接生成 Post，不保存完整的响应文本
+    posts.clear();
+    posts.reserve(limit);
+    StreamingPostParser parser(posts);
+
+    // 发送 GET 请求
+    cpr::Response response = http_client().get(
+            "/posts", header,
+            cpr::Parameters{{"skip", std::to_string(skip)}, {"limit", std::to_string(limit)}},
+            cpr::WriteCallback{[&parser](auto data, intptr_t) { return parser.feed(data); }});
+    bool parsed = parser.finish();
+
+    if (validators && response.status_code == 304) {
+        validators->not_modified = true;
+        posts.clear();
+        return true;
+    }
+
+    // 检查 HTTP 响应状态码
+    if (response.status_code != 200) {
+        if (error) {
+            *error = response.status_code == 0 ? "Failed to fetch posts: " + response.error.message
+                                                : "Failed to fetch posts: HTTP " + std::to_string(response.status_code);
+        }
+        posts.clear();
+        return false;
+    }
+
+    if (!parsed) {
+        if (error) {
+            *error = "Failed to parse posts: " + parser.error();
+        }
+        posts.clear();
+        return false;
+    }
+
+    if (validators) {
+        auto etag = response.header.find("ETag");
+        validators->etag = etag != response.header.end() ? etag->second : "";
+        auto last_modified = response.header.find("Last-Modified");
+        validators->last_modified = last_modified != response.header.end() ? last_modified->second : "";
+    }
+
+    resolve_author_names(posts);
+    return true;
+}
+
+}  // namespace
+
+// 在后台线程调用：cpr、解析和作者名请求抛出的异常都转为失败和错误信息，不传给执行器
+bool fetch_and_parse_posts(int skip, int limit, std::vector<Post>& posts, CacheValidators* validators,
+                           std::string* error) {
+    try {
+        return fetch_and_parse(skip, limit, posts, validators, error);
+    } catch (const std::exception& e) {
+        if (error) {
+            *error = std::string("Failed to fetch posts: ") + e.what();
+        }
+        posts.clear();
+        return false;
+    }
+}
+
+void resolve_author_names(std::vector<Post>& posts) {
+    std::vector<int> author_ids;
+    author_ids.reserve(posts.size());
+    for (const auto& post : posts) {
+        author_ids.push_back(post.author_id);
+    }
+
+    auto author_names = author_directory().resolve(author_ids);
+    for (auto& post : posts) {
+        post.author_name = author_names[post.author_id];
+    }
+}
+
+bool fetch_post_content(int post_id, std::string& content, std::string* error) {
+    TRACE_SCOPE("fetch_content");
+    try {
+        cpr::Response response = http_client().get("/posts/" + std::to_string(post_id), {});
+        if (response.status_code != 200) {
+            if (error) {
+                *error = response.status_code == 0 ? response.error.message
+                                                    : "HTTP " + std::to_string(response.status_code);
+            }
+            return false;
+        }
+
+        TRACE_SCOPE("json_parse");
+        auto json_response = nlohmann::json::parse(response.text);
+        content = json_response["content"].get<std::string>();
+        return true;
+    } catch (const std::exception& e) {
+        if (error) {
+            *error = e.what();
+        }
+        return false;
+    }
+}
+
+
+ContentCache::ContentCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+const std::string* ContentCache::find(int post_id) {
+    auto it = entries_.find(post_id);
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);  // 移到最前
+    return &it->second->second;
+}
+
+const std::string* ContentCache::peek(int post_id) const {
+    auto it = entries_.find(post_id);
+    return it != entries_.end() ? &it->second->second : nullptr;
+}
+
+void ContentCache::insert(int post_id, std::string content) {
+    erase(post_id);
+    bytes_ += content.size();
+    lru_.emplace_front(post_id, std::move(content));
+    entries_[post_id] = lru_.begin();
+
+    // 超出上限时淘汰最久未使用的正文，但至少保留刚插入的一篇
+    while (bytes_ > max_bytes_ && lru_.size() > 1) {
+        bytes_ -= lru_.back().second.size();
+        entries_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+void ContentCache::erase(int post_id) {
+    auto it = entries_.find(post_id);
+    if (it != entries_.end()) {
+        bytes_ -= it->second->second.size();
+        lru_.erase(it->second);
+        entries_.erase(it);
+    }
+}
+
+void ContentCache::clear() {
+    lru_.clear();
+    entries_.clear();
+    bytes_ = 0;
+}
+
+
+PostSource::PostSource(int page_size, size_t content_cache_bytes)
+    : page_size_(page_size > 0 ? page_size : 1), content_cache_(content_cache_bytes) {}
+
+bool PostSource::load_cache(const std::string& path) {
+    if (!disk_cache_.load(path, posts_, validators_, exhausted_)) {
+        return false;
+    }
+    rebuild_positions();
+    search_index_.clear();
+    for (size_t i = 0; i < posts_.size(); ++i) {
+        search_index_.index_title(posts_.id(i), posts_.title(i));  // 正文由 index_idle 逐步建立索引
+    }
+    return true;
+}
+
+bool PostSource::save_cache(const std::string& path) const {
+    return PostDiskCache::save(
+            path, posts_,
+            [this](int post_id, std::string_view& content) {
+                if (const std::string* cached = content_cache_.peek(post_id)) {
+                    content = *cached;
+                    return true;
+                }
+                return disk_cache_.content(post_id, content);
+            },
+            validators_, exhausted_);
+}
+
+void PostSource::refresh(std::function<void()> on_loaded) {
+    unsigned generation = ++generation_;  // 使正在进行的分页请求失效
+    page_in_flight_ = true;
+    int limit = page_size_;
+    CacheValidators validators = validators_;
+    io_executor().submit(
+            [limit, validators]() mutable {
+                std::vector<Post> page;
+                std::string error;
+                bool ok = fetch_and_parse_posts(0, limit, page, &validators, &error);
+                PageTokens tokens = tokenize_contents(page);
+                return std::make_tuple(ok, std::move(page), std::move(tokens), std::move(validators), std::move(error));
+            },
+            [this, generation, on_loaded](
+                    std::tuple<bool, std::vector<Post>, PageTokens, CacheValidators, std::string> result) {
+                if (generation != generation_) {
+                    return;
+                }
+                page_in_flight_ = false;
+                auto& [ok, page, tokens, validators, error] = result;
+                if (ok) {
+                    page_failure_ = LoadFailure();
+                    // 304 时缓存的列表仍然有效，什么都不用做
+                    if (!validators.not_modified) {
+                        merge_first_page(std::move(page), std::move(tokens));
+                    }
+                    validators_ = std::move(validators);
+                } else {
+                    record_failure(page_failure_, std::move(error));
+                }
+                if (on_loaded) {
+                    on_loaded();
+                }
+            });
+}
+
+void PostSource::ensure_loaded(int index) {
+    if (index >= size() && !exhausted_ && !page_in_flight_ && Clock::now() >= page_failure_.retry_at) {
+        // 目标离已加载的末尾很远（跳转）时一次请求多页，最多 MAX_BATCH_PAGES 页
+        int pages = std::clamp((index - size()) / page_size_ + 1, 1, MAX_BATCH_PAGES);
+        request_page(pages * page_size_);
+    }
+}
+
+const std::string* PostSource::content(int post_id) {
+    if (const std::string* cached = content_cache_.find(post_id)) {
+        TRACE_COUNT("content_cache.hit");
+        return cached;
+    }
+    if (const std::string* loaded = load_from_disk(post_id)) {
+        TRACE_COUNT("content_cache.disk");
+        return loaded;
+    }
+    TRACE_COUNT("content_cache.miss");
+    auto failure = content_failures_.find(post_id);
+    if (failure == content_failures_.end() || Clock::now() >= failure->second.retry_at) {
+        fetch_content(post_id, false);
+    }
+    return nullptr;
+}
+
+const std::string* PostSource::content_error(int post_id) const {
+    auto it = content_failures_.find(post_id);
+    return it != content_failures_.end() ? &it->second.error : nullptr;
+}
+
+bool PostSource::content_retry_due(int post_id) const {
+    auto it = content_failures_.find(post_id);
+    return it != content_failures_.end() && !content_in_flight_.count(post_id) && Clock::now() >= it->second.retry_at;
+}
+
+const std::string* PostSource::cached_content(int post_id) {
+    if (const std::string* cached = content_cache_.peek(post_id)) {
+        return cached;
+    }
+    return load_from_disk(post_id);
+}
+
+void PostSource::prefetch(int post_id) {
+    if (!cached_content(post_id) && !content_failures_.count(post_id)) {  // 失败过的正文只在显示时重试
+        fetch_content(post_id, true);
+    }
+}
+
+void PostSource::cancel_prefetch() {
+    ++*prefetch_generation_;
+}
+
+const std::string* PostSource::load_from_disk(int post_id) {
+    std::string_view on_disk;
+    if (!disk_cache_.content(post_id, on_disk)) {
+        return nullptr;
+    }
+    if (!search_index_.has_content(post_id)) {
+        search_index_.index_content(post_id, on_disk);
+    }
+    store_content(post_id, std::string(on_disk));
+    return content_cache_.peek(post_id);
+}
+
+// 预取以低优先级排队；同一篇文章的预取还没完成时，显示它需要的请求仍按普通优先级另外发出
+void PostSource::fetch_content(int post_id, bool background) {
+    auto it = content_in_flight_.find(post_id);
+    if (it != content_in_flight_.end() && (background || !it->second)) {
+        return;
+    }
+    content_in_flight_[post_id] = background;
+
+    auto generation = prefetch_generation_;
+    unsigned current = *generation;
+    // 正文在后台切分成索引词，UI 线程只合并倒排列表，长文章不会卡住输入和绘制
+    auto work = [post_id, background, generation, current]() {
+        std::string content, error;
+        std::vector<std::string> tokens;
+        if (background && *generation != current) {
+            return std::make_tuple(false, std::move(content), std::move(tokens), std::move(error));  // 预取已被取消，不再请求
+        }
+        bool ok = fetch_post_content(post_id, content, &error);
+        if (!ok && error.empty()) {
+            error = "unknown error";
+        }
+        if (ok) {
+            tokens = tokenize(content);
+        }
+        return std::make_tuple(ok, std::move(content), std::move(tokens), std::move(error));
+    };
+    auto done = [this, post_id, background](
+                        std::tuple<bool, std::string, std::vector<std::string>, std::string> result) {
+        auto it = content_in_flight_.find(post_id);
+        if (it != content_in_flight_.end() && it->second == background) {
+            content_in_flight_.erase(it);
+        }
+        auto& [ok, content, tokens, error] = result;
+        if (!ok) {
+            if (!error.empty() && !content_cache_.peek(post_id)) {
+                record_failure(content_failures_[post_id], std::move(error));
+                content_versions_[post_id] = ++last_content_version_;  // 显示的内容变为错误信息
+            }
+            return;
+        }
+        content_failures_.erase(post_id);
+        // 预取和普通请求都返回时只保留先到的一份，已经折行的结果仍然有效
+        if (!content_cache_.peek(post_id)) {
+            search_index_.index_content_tokens(post_id, std::move(tokens), !content.empty());
+            store_content(post_id, std::move(content));
+        }
+    };
+    if (background) {
+        io_executor().submit_background(std::move(work), std::move(done));
+    } else {
+        io_executor().submit(std::move(work), std::move(done));
+    }
+}
+
+void PostSource::request_page(int limit) {
+    unsigned generation = generation_;
+    page_in_flight_ = true;
+    int skip = size();
+    io_executor().submit(
+            [skip, limit]() {
+                std::vector<Post> page;
+                std::string error;
+                bool ok = fetch_and_parse_posts(skip, limit, page, nullptr, &error);
+                PageTokens tokens = tokenize_contents(page);
+                return std::make_tuple(ok, std::move(page), std::move(tokens), std::move(error));
+            },
+            [this, generation, limit](std::tuple<bool, std::vector<Post>, PageTokens, std::string> result) {
+                if (generation != generation_) {
+                    return;  // 期间发生过刷新，丢弃旧结果
+                }
+                page_in_flight_ = false;
+                auto& [ok, page, tokens, error] = result;
+                if (ok) {
+                    page_failure_ = LoadFailure();
+                    append_page(std::move(page), std::move(tokens), limit);
+                } else {
+                    record_failure(page_failure_, std::move(error));
+                }
+            });
+}
+
+void PostSource::append_page(std::vector<Post> page, PageTokens tokens, int limit) {
+    if (static_cast<int>(page.size()) < limit) {
+        exhausted_ = true;  // 不足一页说明已经到达末尾
+    }
+    posts_.reserve(posts_.size() + page.size());
+    for (size_t i = 0; i < page.size(); ++i) {
+        Post& post = page[i];
+        if (!positions_.emplace(post.id, size()).second) {
+            continue;  // 合并过新文章后分页位置可能偏移，跳过已有的文章
+        }
+        search_index_.index_title(post.id, post.title);
+        take_content(post, std::move(tokens[i]));
+        posts_.push_back(post);
+    }
+}
+
+// 用最新的第一页更新列表：第一页中的文章按服务器顺序排在前面并替换旧的摘要，
+// 其余已加载的文章保持原来的顺序。标题或发布时间变化的文章丢弃缓存的正文
+void PostSource::merge_first_page(std::vector<Post> page, PageTokens tokens) {
+    bool complete = static_cast<int>(page.size()) < page_size_;  // 服务器上的文章不足一页
+
+    PostStore merged;
+    merged.reserve(complete ? page.size() : page.size() + posts_.size());
+    std::unordered_set<int> merged_ids;
+    for (size_t i = 0; i < page.size(); ++i) {
+        Post& post = page[i];
+        auto it = positions_.find(post.id);
+        if (it != positions_.end() && !posts_.same_summary(it->second, post)) {
+            forget_content(post.id);
+        }
+        search_index_.index_title(post.id, post.title);
+        take_content(post, std::move(tokens[i]));
+        merged_ids.insert(post.id);
+        merged.push_back(post);
+    }
+
+    // 第一页已经包含全部文章时，不在其中的旧文章已被删除
+    for (size_t i = 0; i < posts_.size(); ++i) {
+        int post_id = posts_.id(i);
+        if (merged_ids.count(post_id)) {
+            continue;
+        }
+        if (complete) {
+            search_index_.remove(post_id);
+        } else {
+            merged_ids.insert(post_id);
+            merged.append_from(posts_, i);
+        }
+    }
+    if (complete) {
+        exhausted_ = true;
+    }
+
+    posts_ = std::move(merged);
+    rebuild_positions();
+}
+
+void PostSource::apply_changes(FeedChanges changes) {
+    std::vector<Post> added;
+    changes.tokens.resize(changes.posts.size());
+    for (size_t i = 0; i < changes.posts.size(); ++i) {
+        Post& post = changes.posts[i];
+        auto it = positions_.find(post.id);
+        if (it == positions_.end()) {
+            search_index_.index_title(post.id, post.title);
+            take_content(post, std::move(changes.tokens[i]));
+            added.push_back(std::move(post));
+            continue;
+        }
+        // 修改过的文章：带回的正文与已知的不同时替换旧正文，否则在标题或发布时间变化时丢弃旧正文。
+        // 轮询第一页时每篇文章都会带回，大多没有变化，不能因此丢弃缓存的正文和折行结果
+        if (!posts_.same_summary(it->second, post) || (!post.content.empty() && !same_content(post.id, post.content))) {
+            forget_content(post.id);
+        }
+        search_index_.index_title(post.id, post.title);
+        take_content(post, std::move(changes.tokens[i]));
+        posts_.update(it->second, post);
+    }
+
+    std::unordered_set<int> removed;
+    for (int post_id : changes.deleted) {
+        if (positions_.count(post_id) && removed.insert(post_id).second) {
+            forget_content(post_id);
+            search_index_.remove(post_id);
+        }
+    }
+    if (added.empty() && removed.empty()) {
+        return;
+    }
+
+    PostStore merged;
+    merged.reserve(added.size() + posts_.size() - removed.size());
+    for (const auto& post : added) {
+        merged.push_back(post);
+    }
+    for (size_t i = 0; i < posts_.size(); ++i) {
+        if (!removed.count(posts_.id(i))) {
+            merged.append_from(posts_, i);
+        }
+    }
+    posts_ = std::move(merged);
+    rebuild_positions();
+}
+
+int PostSource::index_of(int post_id) const {
+    auto it = positions_.find(post_id);
+    return it != positions_.end() ? it->second : -1;
+}
+
+// 列表中只保留摘要，随分页带回的正文建立索引后移入正文缓存；与已缓存的相同时不替换，版本不变。
+// tokens 是后台切分好的正文索引词，为空时在这里切分
+void PostSource::take_content(Post& post, std::vector<std::string> tokens) {
+    if (!post.content.empty()) {
+        if (!same_content(post.id, post.content)) {
+            if (tokens.empty()) {
+                tokens = tokenize(post.content);
+            }
+            search_index_.index_content_tokens(post.id, std::move(tokens), true);
+            store_content(post.id, std::move(post.content));
+        }
+        post.content = std::string();
+    }
+}
+
+// 第 n 次连续失败后等待 MIN_RETRY * 2^(n-1)，最多 MAX_RETRY
+void PostSource::record_failure(LoadFailure& failure, std::string error) {
+    ++failure.failures;
+    failure.retry_at = Clock::now() + std::min<Clock::duration>(MAX_RETRY, MIN_RETRY * (1 << std::min(failure.failures - 1, 6)));
+    failure.error = std::move(error);
+}
+
+// 与内存或磁盘缓存中的正文比较，不改变缓存
+bool PostSource::same_content(int post_id, std::string_view content) const {
+    std::string_view known;
+    if (const std::string* cached = content_cache_.peek(post_id)) {
+        known = *cached;
+    } else if (!disk_cache_.content(post_id, known)) {
+        return false;
+    }
+    return known == content;
+}
+
+uint64_t PostSource::content_version(int post_id) const {
+    auto it = content_versions_.find(post_id);
+    return it != content_versions_.end() ? it->second : 0;
+}
+
+// 正文缓存只通过这里和 forget_content 修改，版本号随之更新；
+// 不用正文的地址判断是否变化，释放后新分配的正文可能恰好在同一地址
+void PostSource::store_content(int post_id, std::string content) {
+    content_cache_.insert(post_id, std::move(content));
+    content_versions_[post_id] = ++last_content_version_;
+}
+
+void PostSource::forget_content(int post_id) {
+    content_versions_[post_id] = ++last_content_version_;
+    content_cache_.erase(post_id);
+    disk_cache_.forget_content(post_id);
+    search_index_.index_content(post_id, {});
+}
+
+void PostSource::rebuild_positions() {
+    positions_.clear();
+    positions_.reserve(posts_.size());
+    for (int i = 0; i < size(); ++i) {
+        positions_.emplace(posts_.id(i), i);
+    }
+    index_cursor_ = 0;
+}
+
+std::vector<int> PostSource::search(std::string_view query) const {
+    std::vector<int> matches;
+    for (int post_id : search_index_.search(query)) {
+        auto it = positions_.find(post_id);
+        if (it != positions_.end()) {
+            matches.push_back(it->second);
+        }
+    }
+    std::sort(matches.begin(), matches.end());
+    return matches;
+}
+
+bool PostSource::index_idle(size_t max_posts) {
+    size_t indexed = 0;
+    std::string_view on_disk;
+    for (; index_cursor_ < posts_.size() && indexed < max_posts; ++index_cursor_) {
+        int post_id = posts_.id(index_cursor_);
+        if (!search_index_.has_content(post_id) && disk_cache_.content(post_id, on_disk)) {
+            search_index_.index_content(post_id, on_disk);
+            ++indexed;
+        }
+    }
+    return indexed > 0;
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "live_feed.h"
+#include "post.h"
+#include "post_cache.h"
+#include "post_store.h"
+#include "search_index.h"
+
+// 分页获取文章，skip/limit 对应后端的分页参数，失败时返回 false。
+// 传入 validators 时发送条件请求：返回 304 时 validators->not_modified 为 true，posts 不变；
+// 返回 200 时用响应中的 ETag / Last-Modified 更新 validators。
+// 失败的原因写入 error（可以为空），由调用方显示：界面运行时不能写 stderr
+bool fetch_and_parse_posts(int skip, int limit, std::vector<Post>& posts, CacheValidators* validators = nullptr,
+                           std::string* error = nullptr);
+
+// 为一批文章填写作者名，每个不同的作者只请求一次，已缓存的作者不再请求
+void resolve_author_names(std::vector<Post>& posts);
+
+// 获取单篇文章的正文，失败的原因写入 error（可以为空）
+bool fetch_post_content(int post_id, std::string& content, std::string* error = nullptr);
+
+// 文章正文缓存：按正文总字节数限制大小的 LRU
+class ContentCache {
+public:
+    explicit ContentCache(size_t max_bytes);
+
+    // 命中时返回正文并标记为最近使用，否则返回 nullptr
+    const std::string* find(int post_id);
+    // 与 find 相同，但不改变淘汰顺序
+    const std::string* peek(int post_id) const;
+    void insert(int post_id, std::string content);
+    void erase(int post_id);
+    void clear();
+
+private:
+    size_t max_bytes_;
+    size_t bytes_ = 0;
+    std::list<std::pair<int, std::string>> lru_;  // 最近使用的在前
+    std::unordered_map<int, std::list<std::pair<int, std::string>>::iterator> entries_;
+};
+
+// 按窗口加载的文章来源：列表只保存摘要（列式存储在 PostStore 中），按页向后加载；
+// 正文在第一次显示时才请求，并保存在有上限的缓存中。
+// 启动时可以先从磁盘缓存加载，再在后台用条件请求重新验证第一页。
+// 所有方法只能在 UI 线程调用，网络请求通过 io_executor 在后台执行。
+// 分页或正文请求失败后记录原因，并按连续失败的次数退避，退避期间不再发出同样的请求
+class PostSource {
+public:
+    static const int MAX_BATCH_PAGES = 10;  // ensure_loaded 一次最多请求的页数
+
+    explicit PostSource(int page_size = 50, size_t content_cache_bytes = 8 << 20);
+
+    const PostStore& posts() const { return posts_; }
+    bool empty() const { return posts_.empty(); }
+    int size() const { return static_cast<int>(posts_.size()); }
+    int id(int index) const { return posts_.id(index); }
+
+    // 文章在列表中的下标，不在列表中时返回 -1
+    int index_of(int post_id) const;
+
+    // 已经加载到列表末尾（后端没有更多文章）
+    bool exhausted() const { return exhausted_; }
+
+    // 最近一次加载列表失败的原因，之后加载成功时清空
+    const std::string& load_error() const { return page_failure_.error; }
+
+    // 从磁盘缓存加载文章列表，可以立即显示
+    bool load_cache(const std::string& path);
+
+    // 把当前列表和已知的正文写入磁盘缓存
+    bool save_cache(const std::string& path) const;
+
+    // 在后台重新验证第一页，并把新增和修改的文章合并进列表；完成后在 UI 线程调用 on_loaded
+    void refresh(std::function<void()> on_loaded);
+
+    // 合并订阅推送的变更：已有的文章原地更新，新文章按服务器顺序插到列表前面，
+    // 删除的文章移出列表；只处理变化的文章，没有新增或删除时列表不重排
+    void apply_changes(FeedChanges changes);
+
+    // 保证至少加载到 index（不含）之前的文章，不足时在后台请求后面的页；
+    // index 离已加载的末尾很远时一次请求多页，跳转到很靠后的位置时请求数较少
+    void ensure_loaded(int index);
+
+    // 返回文章正文；内存和磁盘缓存都没有时在后台请求并返回 nullptr
+    const std::string* content(int post_id);
+
+    // 内存或磁盘缓存中的正文，不发出请求，也不改变缓存的淘汰顺序；没有时返回 nullptr
+    const std::string* cached_content(int post_id);
+
+    // 上一次请求正文失败的原因，之后请求成功时清空；没有失败时返回 nullptr
+    const std::string* content_error(int post_id) const;
+
+    // 正文请求失败后退避的时间已到，下一次 content() 会重新请求
+    bool content_retry_due(int post_id) const;
+
+    // 正文的版本号：每次放入或丢弃这篇文章的正文、或者请求失败时变为新的值，用于判断缓存的显示结果是否仍然有效
+    uint64_t content_version(int post_id) const;
+
+    // 缓存中没有正文时以低优先级在后台请求，结果放入正文缓存
+    void prefetch(int post_id);
+
+    // 取消尚未开始的预取，用于跳转后旧位置附近的文章不再需要时
+    void cancel_prefetch();
+
+    // 在已加载的文章中搜索，返回匹配文章在列表中的下标（按列表顺序）。
+    // 标题在加载时建立索引，正文在第一次可用时建立索引
+    std::vector<int> search(std::string_view query) const;
+
+    // 空闲时为磁盘缓存中尚未索引的正文建立索引，每次最多处理 max_posts 篇；有进展时返回 true
+    bool index_idle(size_t max_posts);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // 连续失败的请求：在 retry_at 之前不再请求
+    struct LoadFailure {
+        int failures = 0;
+        Clock::time_point retry_at;
+        std::string error;
+    };
+
+    static void record_failure(LoadFailure& failure, std::string error);
+
+    void request_page(int limit);
+    // 与分页一一对应的正文切分结果，在后台线程中生成；没有正文的文章为空
+    using PageTokens = std::vector<std::vector<std::string>>;
+
+    void append_page(std::vector<Post> page, PageTokens tokens, int limit);
+    void merge_first_page(std::vector<Post> page, PageTokens tokens);
+    const std::string* load_from_disk(int post_id);
+    void fetch_content(int post_id, bool background);
+    void take_content(Post& post, std::vector<std::string> tokens);
+    bool same_content(int post_id, std::string_view content) const;
+    void store_content(int post_id, std::string content);
+    void forget_content(int post_id);
+    void rebuild_positions();
+
+    int page_size_;
+    PostStore posts_;
+    bool exhausted_ = false;
+    bool page_in_flight_ = false;
+    LoadFailure page_failure_;  // 分页和刷新共用
+    unsigned generation_ = 0;  // 每次刷新递增，用于丢弃过期的分页结果
+
+    std::unordered_map<int, int> positions_;  // 文章 id -> 列表下标，也用于分页去重
+
+    ContentCache content_cache_;
+    std::unordered_map<int, bool> content_in_flight_;  // 文章 id -> 是否只有预取请求
+    std::unordered_map<int, uint64_t> content_versions_;  // 文章 id -> 正文版本
+    std::unordered_map<int, LoadFailure> content_failures_;  // 文章 id -> 请求正文的连续失败
+    uint64_t last_content_version_ = 0;
+    // 每次取消预取时递增，排队中的预取发现它变化后不再请求
+    std::shared_ptr<std::atomic<unsigned>> prefetch_generation_ = std::make_shared<std::atomic<unsigned>>(0);
+
+    PostDiskCache disk_cache_;
+    CacheValidators validators_;
+
+    SearchIndex search_index_;
+    size_t index_cursor_ = 0;  // index_idle 下一次检查的列表位置
+};
@@ -0,0 +1,200 @@
+#include "post_store.h"
+
+#include <cstdio>
+
+#include "text_width.h"
+
+namespace {
+
+// 读取固定位数的十进制数
+bool read_digits(std::string_view text, size_t pos, size_t count, int& value) {
+    if (pos + count > text.size()) return false;
+    value = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        if (text[i] < '0' || text[i] > '9') return false;
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+// 公历日期到 1970-01-01 的天数
+int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civil_from_days(int64_t z, int& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int>(static_cast<int64_t>(yoe) + era * 400 + (m <= 2));
+}
+
+}  // namespace
+
+std::string make_label(std::string_view title, int columns) {
+    int used;
+    size_t cut = fit_columns(title, columns, used);
+    if (cut == title.size()) {
+        return std::string(title);
+    }
+    return std::string(title.substr(0, cut)) + "...";
+}
+
+int64_t parse_timestamp(std::string_view text) {
+    int year, month, day, hour, minute, second;
+    if (!read_digits(text, 0, 4, year) || text.size() < 19 || text[4] != '-' || !read_digits(text, 5, 2, month) ||
+        text[7] != '-' || !read_digits(text, 8, 2, day) || (text[10] != 'T' && text[10] != ' ') ||
+        !read_digits(text, 11, 2, hour) || text[13] != ':' || !read_digits(text, 14, 2, minute) || text[16] != ':' ||
+        !read_digits(text, 17, 2, second) || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 ||
+        minute > 59 || second > 60) {
+        return UNKNOWN_TIME;
+    }
+
+    size_t pos = 19;
+    if (pos < text.size() && text[pos] == '.') {  // 忽略秒的小数部分
+        ++pos;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') ++pos;
+    }
+    int64_t zone = 0;
+    if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+        int zone_hour, zone_minute;
+        if (!read_digits(text, pos + 1, 2, zone_hour) || pos + 3 >= text.size() || text[pos + 3] != ':' ||
+            !read_digits(text, pos + 4, 2, zone_minute)) {
+            return UNKNOWN_TIME;
+        }
+        zone = (zone_hour * 3600 + zone_minute * 60) * (text[pos] == '+' ? 1 : -1);
+        pos += 6;
+    } else if (pos < text.size() && text[pos] == 'Z') {
+        ++pos;
+    }
+    if (pos != text.size()) {
+        return UNKNOWN_TIME;
+    }
+    return days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - zone;
+}
+
+std::string format_timestamp(int64_t time) {
+    if (time == UNKNOWN_TIME) {
+        return "";
+    }
+    int64_t days = time >= 0 ? time / 86400 : (time - 86399) / 86400;
+    int64_t seconds = time - days * 86400;
+    int year;
+    unsigned month, day;
+    civil_from_days(days, year, month, day);
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02u-%02uT%02d:%02d:%02d", year, month, day,
+                  static_cast<int>(seconds / 3600), static_cast<int>(seconds / 60 % 60), static_cast<int>(seconds % 60));
+    return buffer;
+}
+
+
+uint32_t StringPool::intern(std::string_view value) {
+    auto it = ids_.find(value);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(strings_.size());
+    strings_.emplace_back(value);
+    ids_.emplace(strings_.back(), id);
+    return id;
+}
+
+void StringPool::clear() {
+    ids_.clear();
+    strings_.clear();
+}
+
+
+PostStore::Span PostStore::Arena::append(std::string_view value) {
+    Span span{static_cast<uint32_t>(bytes.size()), static_cast<uint32_t>(value.size())};
+    bytes.append(value);
+    return span;
+}
+
+void PostStore::reserve(size_t count) {
+    ids_.reserve(count);
+    author_ids_.reserve(count);
+    author_refs_.reserve(count);
+    published_.reserve(count);
+    titles_.spans.reserve(count);
+    labels_.spans.reserve(count);
+}
+
+void PostStore::clear() {
+    ids_.clear();
+    author_ids_.clear();
+    author_refs_.clear();
+    published_.clear();
+    titles_ = Arena{};
+    labels_ = Arena{};
+    authors_.clear();
+}
+
+void PostStore::push_back(const Post& post) {
+    push_back(post.id, post.author_id, post.title, parse_timestamp(post.published), post.author_name);
+}
+
+void PostStore::push_back(int id, int author_id, std::string_view title, int64_t published, std::string_view author_name) {
+    ids_.push_back(id);
+    author_ids_.push_back(author_id);
+    author_refs_.push_back(authors_.intern(author_name));
+    published_.push_back(published);
+    titles_.spans.push_back({});
+    labels_.spans.push_back({});
+    set_title(ids_.size() - 1, title, false);
+}
+
+void PostStore::append_from(const PostStore& other, size_t index) {
+    push_back(other.id(index), other.author_id(index), other.title(index), other.published(index),
+              other.author_name(index));
+}
+
+void PostStore::update(size_t index, const Post& post) {
+    author_ids_[index] = post.author_id;
+    author_refs_[index] = authors_.intern(post.author_name);
+    published_[index] = parse_timestamp(post.published);
+    if (title(index) != post.title) {
+        set_title(index, post.title, true);
+        compact_if_needed();
+    }
+}
+
+bool PostStore::same_summary(size_t index, const Post& post) const {
+    return title(index) == post.title && published(index) == parse_timestamp(post.published);
+}
+
+void PostStore::set_title(size_t index, std::string_view title, bool replace) {
+    if (replace) {
+        titles_.garbage += titles_[index].length;
+        labels_.garbage += labels_[index].length;
+    }
+    titles_[index] = titles_.append(title);
+    labels_[index] = labels_.append(make_label(title));
+}
+
+// 被替换的旧标题超过字符串区的一半时重新排列，去掉不再使用的部分
+void PostStore::compact_if_needed() {
+    for (Arena* arena : {&titles_, &labels_}) {
+        if (arena->garbage * 2 <= arena->bytes.size()) {
+            continue;
+        }
+        Arena compacted;
+        compacted.bytes.reserve(arena->bytes.size() - arena->garbage);
+        compacted.spans.reserve(arena->spans.size());
+        for (const Span& span : arena->spans) {
+            compacted.spans.push_back(compacted.append(view(*arena, span)));
+        }
+        *arena = std::move(compacted);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "post.h"
+
+// 预先计算的侧边栏标签最多保留的标题宽度（终端列数），对应默认的侧边栏宽度；更长的标题截断后加 "..."
+const int SIDEBAR_LABEL_COLUMNS = 20;
+
+// 截断到 columns 列作为侧边栏标签，不切断 UTF-8 字符和字符簇，宽字符按 2 列计算
+std::string make_label(std::string_view title, int columns = SIDEBAR_LABEL_COLUMNS);
+
+// 无法解析的发布时间
+const int64_t UNKNOWN_TIME = std::numeric_limits<int64_t>::min();
+
+// 解析 ISO 8601 时间（YYYY-MM-DD[T ]HH:MM:SS[.ffffff][Z|±HH:MM]），返回 UTC 秒数；
+// 没有时区时按 UTC 处理，格式不正确时返回 UNKNOWN_TIME
+int64_t parse_timestamp(std::string_view text);
+
+// 格式化为 YYYY-MM-DDTHH:MM:SS，UNKNOWN_TIME 返回空字符串
+std::string format_timestamp(int64_t time);
+
+// 字符串驻留表：相同的字符串只保存一份，用 32 位编号引用
+class StringPool {
+public:
+    uint32_t intern(std::string_view value);
+    std::string_view get(uint32_t id) const { return strings_[id]; }
+    size_t size() const { return strings_.size(); }
+    void clear();
+
+private:
+    std::deque<std::string> strings_;  // deque 追加时不移动已有元素，ids_ 的键保持有效
+    std::unordered_map<std::string_view, uint32_t> ids_;
+};
+
+// 文章摘要的列式存储：每个字段一个数组，标题连续存放在字符串区中，
+// 侧边栏标签（截断后的标题）预先计算并单独存放，绘制侧边栏时只访问标签数组。
+// 作者名驻留，发布时间解析为整数；正文不在这里，由 PostSource 的缓存管理
+class PostStore {
+public:
+    size_t size() const { return ids_.size(); }
+    bool empty() const { return ids_.empty(); }
+    void reserve(size_t count);
+    void clear();
+
+    void push_back(const Post& post);
+    void push_back(int id, int author_id, std::string_view title, int64_t published, std::string_view author_name);
+    // 从另一个存储复制第 index 篇文章
+    void append_from(const PostStore& other, size_t index);
+    // 用新的摘要替换第 index 篇文章，id 不变
+    void update(size_t index, const Post& post);
+
+    int id(size_t index) const { return ids_[index]; }
+    int author_id(size_t index) const { return author_ids_[index]; }
+    std::string_view title(size_t index) const { return view(titles_, titles_[index]); }
+    std::string_view label(size_t index) const { return view(labels_, labels_[index]); }
+    std::string_view author_name(size_t index) const { return authors_.get(author_refs_[index]); }
+    int64_t published(size_t index) const { return published_[index]; }
+
+    // 与 Post 比较标题和发布时间是否相同
+    bool same_summary(size_t index, const Post& post) const;
+
+private:
+    // 字符串区中的一段
+    struct Span {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct Arena {
+        std::string bytes;
+        std::vector<Span> spans;
+        size_t garbage = 0;  // 被替换的旧字符串占用的字节
+        Span append(std::string_view value);
+        Span& operator[](size_t index) { return spans[index]; }
+        const Span& operator[](size_t index) const { return spans[index]; }
+    };
+
+    static std::string_view view(const Arena& arena, Span span) {
+        return std::string_view(arena.bytes).substr(span.offset, span.length);
+    }
+    void set_title(size_t index, std::string_view title, bool replace);
+    void compact_if_needed();
+
+    std::vector<int> ids_;
+    std::vector<int> author_ids_;
+    std::vector<uint32_t> author_refs_;
+    std::vector<int64_t> published_;
+    Arena titles_;
+    Arena labels_;
+    StringPool authors_;
+};
@@ -0,0 +1,139 @@
+#include "post_upload.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char JSON_TAIL[] = "\"}";
+const size_t RELEASE_STEP = 8 << 20;  // 每输出这么多正文回收一次已用过的页
+
+// 不需要转义的字节：除引号、反斜杠和控制字符以外的所有字节（包括 UTF-8 多字节字符）
+bool plain(unsigned char c) {
+    return c >= 0x20 && c != '"' && c != '\\';
+}
+
+// 一个需要转义的字节对应的转义序列
+std::string escape(unsigned char c) {
+    switch (c) {
+        case '"': return "\\\"";
+        case '\\': return "\\\\";
+        case '\n': return "\\n";
+        case '\r': return "\\r";
+        case '\t': return "\\t";
+        case '\b': return "\\b";
+        case '\f': return "\\f";
+        default: {
+            char buffer[8];
+            std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            return buffer;
+        }
+    }
+}
+
+size_t escaped_size(unsigned char c) {
+    switch (c) {
+        case '"': case '\\': case '\n': case '\r': case '\t': case '\b': case '\f': return 2;
+        default: return c < 0x20 ? 6 : 1;
+    }
+}
+
+std::string escape_all(std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    for (unsigned char c : text) {
+        if (plain(c)) {
+            out.push_back(static_cast<char>(c));
+        } else {
+            out += escape(c);
+        }
+    }
+    return out;
+}
+
+}  // namespace
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+bool MappedFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    madvise(mapped, st.st_size, MADV_SEQUENTIAL);  // 只顺序读一遍，预读后面的页
+    data_ = static_cast<const char*>(mapped);
+    size_ = st.st_size;
+    return true;
+}
+
+void MappedFile::release(size_t offset) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t end = offset / page * page;
+    if (end >= released_ + RELEASE_STEP) {
+        madvise(const_cast<char*>(data_) + released_, end - released_, MADV_DONTNEED);
+        released_ = end;
+    }
+}
+
+
+PostBodyStream::PostBodyStream(const std::string& title, std::string_view content)
+    : head_("{\"title\":\"" + escape_all(title) + "\",\"content\":\""), content_(content) {
+    size_ = head_.size() + sizeof(JSON_TAIL) - 1;
+    for (unsigned char c : content_) {
+        size_ += escaped_size(c);
+    }
+}
+
+size_t PostBodyStream::read(char* buffer, size_t capacity) {
+    size_t written = 0;
+    auto put = [&](const char* data, size_t length) {
+        size_t n = std::min(length, capacity - written);
+        std::memcpy(buffer + written, data, n);
+        written += n;
+        return n;
+    };
+
+    head_pos_ += put(head_.data() + head_pos_, head_.size() - head_pos_);
+
+    while (written < capacity && (!pending_.empty() || content_pos_ < content_.size())) {
+        if (!pending_.empty()) {
+            pending_.erase(0, put(pending_.data(), pending_.size()));
+            continue;
+        }
+        // 连续的普通字节直接复制，只扫描缓冲区还能放下的部分
+        size_t run = content_pos_;
+        size_t limit = std::min(content_.size(), content_pos_ + (capacity - written));
+        while (run < limit && plain(static_cast<unsigned char>(content_[run]))) {
+            ++run;
+        }
+        if (run > content_pos_) {
+            content_pos_ += put(content_.data() + content_pos_, run - content_pos_);
+            continue;
+        }
+        pending_ = escape(static_cast<unsigned char>(content_[content_pos_++]));
+    }
+
+    if (content_pos_ == content_.size() && pending_.empty()) {
+        tail_pos_ += put(JSON_TAIL + tail_pos_, sizeof(JSON_TAIL) - 1 - tail_pos_);
+    }
+    return written;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// 只读映射的文件，用于上传大文件而不把它读进内存
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 映射整个文件，文件不存在或为空时返回 false
+    bool open(const std::string& path);
+
+    std::string_view data() const { return std::string_view(data_, size_); }
+
+    // 告诉内核 [0, offset) 已经用完，可以回收这些页，保持常驻内存不随文件增长
+    void release(size_t offset);
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t released_ = 0;
+};
+
+// 按需生成 {"title": ..., "content": ...} 请求体：标题预先转义，正文边转义边输出，
+// 不会生成完整的请求体。总长度在构造时计算好，可以作为 Content-Length
+class PostBodyStream {
+public:
+    PostBodyStream(const std::string& title, std::string_view content);
+
+    // 请求体的总字节数
+    uint64_t size() const { return size_; }
+
+    // 写入最多 capacity 字节，返回写入的字节数；全部写完后返回 0
+    size_t read(char* buffer, size_t capacity);
+
+    // 已经输出的正文字节数（转义前）
+    size_t content_offset() const { return content_pos_; }
+
+private:
+    std::string head_;  // {"title":"...","content":"
+    std::string_view content_;
+    std::string pending_;  // 没有完整写入缓冲区的转义序列
+    size_t head_pos_ = 0;
+    size_t content_pos_ = 0;
+    size_t tail_pos_ = 0;
+    uint64_t size_ = 0;
+};
+
+// 上传进度，由工作线程更新，UI 线程读取后显示在状态栏
+struct UploadProgress {
+    std::atomic<bool> active{false};
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> total{0};
+};
@@ -0,0 +1,81 @@
+#include "prefetcher.h"
+
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "io_executor.h"
+
+Prefetcher::Prefetcher(int ahead, int behind) : ahead_(ahead), behind_(behind) {}
+
+void Prefetcher::update(PostSource& posts, LayoutCache& layouts, int row, const std::function<int(int)>& post_at,
+                        int width) {
+    if (row != last_row_) {
+        int delta = row - last_row_;
+        if (last_row_ >= 0 && std::abs(delta) > 1) {
+            // 跳到了别处，旧位置附近排队中的预取和折行都不再需要
+            ++*generation_;
+            posts.cancel_prefetch();
+        } else if (last_row_ >= 0) {
+            direction_ = delta;
+        }
+        last_row_ = row;
+        requested_.clear();
+    }
+    if (width <= 0) {
+        return;
+    }
+
+    // 前进方向上的文章先排队
+    for (int k = 1; k <= ahead_; ++k) {
+        prepare(posts, layouts, post_at(row + direction_ * k), width);
+    }
+    for (int k = 1; k <= behind_; ++k) {
+        prepare(posts, layouts, post_at(row - direction_ * k), width);
+    }
+}
+
+void Prefetcher::reset() {
+    ++*generation_;
+}
+
+void Prefetcher::prepare(PostSource& posts, LayoutCache& layouts, int index, int width) {
+    if (index < 0 || index >= posts.size()) {
+        return;
+    }
+    int post_id = posts.id(index);
+    const std::string* content = posts.cached_content(post_id);
+    if (!content) {
+        if (requested_.insert(post_id).second) {
+            posts.prefetch(post_id);  // 正文到达后，下一次 update 再折行
+        }
+        return;
+    }
+    uint64_t version = posts.content_version(post_id);
+    if (layouts.contains(post_id, version, width) || !layout_in_flight_.insert(post_id).second) {
+        return;
+    }
+
+    // 渲染和折行在后台线程对正文的副本进行，完成时正文的版本没有变化才放入缓存
+    auto generation = generation_;
+    unsigned current = *generation;
+    io_executor().submit_background(
+            [text = *content, width, generation, current]() {
+                PostLayout layout;
+                if (*generation == current) {
+                    layout = layout_post(text, width);
+                }
+                return layout;
+            },
+            [this, &posts, &layouts, post_id, version, width, generation, current](PostLayout layout) {
+                layout_in_flight_.erase(post_id);
+                if (*generation != current || !layout.body) {
+                    return;  // 已取消，或折行时抛出异常
+                }
+                if (posts.cached_content(post_id) && posts.content_version(post_id) == version &&
+                    !layouts.contains(post_id, version, width)) {
+                    layouts.insert(post_id, version, width, std::move(layout));
+                }
+            });
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+
+#include "post_source.h"
+#include "text_layout.h"
+
+// 预测下一篇要看的文章：按最近的移动方向，在后台以低优先级预取后面 ahead 篇和前面 behind 篇的正文，
+// 并在后台线程渲染 Markdown、按当前宽度折行，顺序翻页时正文和显示结果都已在缓存中。
+// 一次移动超过一篇（跳转、Home/End）时取消尚未开始的旧预取
+class Prefetcher {
+public:
+    explicit Prefetcher(int ahead = 3, int behind = 1);
+
+    // 当前选中第 row 行；post_at 把行转换为文章在列表中的下标，超出范围时返回 -1。
+    // 每次主循环调用一次，没有变化时只做几次缓存查找；只能在 UI 线程调用
+    void update(PostSource& posts, LayoutCache& layouts, int row, const std::function<int(int)>& post_at, int width);
+    // 窗口宽度变化：丢弃按旧宽度排队和进行中的折行，下一次 update 按新宽度重新准备
+    void reset();
+
+private:
+    void prepare(PostSource& posts, LayoutCache& layouts, int index, int width);
+
+    int ahead_;
+    int behind_;
+    int last_row_ = -1;
+    int direction_ = 1;  // 最近一次移动的方向
+
+    std::unordered_set<int> requested_;         // 当前位置已经请求过正文的文章，失败后不反复请求
+    std::unordered_set<int> layout_in_flight_;  // 正在后台折行的文章
+    std::shared_ptr<std::atomic<unsigned>> generation_ = std::make_shared<std::atomic<unsigned>>(0);
+};
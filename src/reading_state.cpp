@@ -0,0 +1,268 @@
+#include "reading_state.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <unistd.h>
+
+#include "post_upload.h"
+
+namespace {
+
+const size_t RECORD_SIZE = 16;
+const uint8_t RECORD_ENTRY = 1;
+const uint8_t RECORD_POSITION = 2;
+const uint8_t FLAG_READ = 1;
+const uint8_t FLAG_BOOKMARKED = 2;
+const int POSITION_KEY = -1;       // 选中的文章在待写入表中的 key
+const uint64_t MIN_COMPACT_RECORDS = 1024;  // 文件较小时不重写
+
+uint32_t fnv1a(std::string_view data) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : data) {
+        hash = (hash ^ c) * 16777619u;
+    }
+    return hash;
+}
+
+void encode(int post_id, const ReadingEntry& entry, uint8_t type, std::string& out) {
+    char record[RECORD_SIZE] = {};
+    uint32_t id = static_cast<uint32_t>(post_id);
+    uint32_t offset = static_cast<uint32_t>(entry.offset);
+    uint8_t flags = (entry.read ? FLAG_READ : 0) | (entry.bookmarked ? FLAG_BOOKMARKED : 0);
+    std::memcpy(record, &id, 4);
+    std::memcpy(record + 4, &offset, 4);
+    record[8] = static_cast<char>(type);
+    record[9] = static_cast<char>(flags);
+    uint32_t checksum = fnv1a(std::string_view(record, 12));
+    std::memcpy(record + 12, &checksum, 4);
+    out.append(record, RECORD_SIZE);
+}
+
+// 校验失败或类型未知时返回 false
+bool decode(std::string_view record, int& post_id, ReadingEntry& entry, uint8_t& type) {
+    uint32_t id, offset, checksum;
+    std::memcpy(&id, record.data(), 4);
+    std::memcpy(&offset, record.data() + 4, 4);
+    std::memcpy(&checksum, record.data() + 12, 4);
+    type = static_cast<uint8_t>(record[8]);
+    uint8_t flags = static_cast<uint8_t>(record[9]);
+    if (checksum != fnv1a(record.substr(0, 12)) || (type != RECORD_ENTRY && type != RECORD_POSITION)) {
+        return false;
+    }
+    post_id = static_cast<int>(id);
+    entry.offset = static_cast<int>(offset);
+    entry.read = flags & FLAG_READ;
+    entry.bookmarked = flags & FLAG_BOOKMARKED;
+    return true;
+}
+
+bool write_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t n = write(fd, data.data(), data.size());
+        if (n < 0) return false;
+        data.remove_prefix(n);
+    }
+    return true;
+}
+
+}  // namespace
+
+ReadingState::ReadingState(std::string path, std::chrono::milliseconds flush_interval)
+    : path_(std::move(path)), flush_interval_(flush_interval) {}
+
+ReadingState::~ReadingState() {
+    stop();
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool ReadingState::open() {
+    if (fd_ >= 0) {
+        return true;
+    }
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        return false;
+    }
+
+    // 重放日志，后面的记录覆盖前面的
+    MappedFile log;
+    uint64_t valid = 0;
+    if (log.open(path_)) {
+        std::string_view data = log.data();
+        for (; data.size() - valid >= RECORD_SIZE; valid += RECORD_SIZE) {
+            int post_id;
+            ReadingEntry entry;
+            uint8_t type;
+            if (!decode(data.substr(valid, RECORD_SIZE), post_id, entry, type)) {
+                break;
+            }
+            if (type == RECORD_POSITION) {
+                position_ = post_id;
+            } else if (entry.empty()) {
+                entries_.erase(post_id);
+            } else {
+                entries_[post_id] = entry;
+            }
+        }
+        if (valid < data.size() && ftruncate(fd_, valid) != 0) {
+            return false;
+        }
+    }
+    record_count_ = valid / RECORD_SIZE;
+    persisted_ = entries_;
+    persisted_position_ = position_;
+
+    stopping_ = false;
+    thread_ = std::thread(&ReadingState::run, this);
+    return true;
+}
+
+void ReadingState::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+ReadingEntry ReadingState::get(int post_id) const {
+    auto it = entries_.find(post_id);
+    return it != entries_.end() ? it->second : ReadingEntry{};
+}
+
+void ReadingState::set_read(int post_id, bool read) {
+    ReadingEntry entry = get(post_id);
+    if (entry.read != read) {
+        entry.read = read;
+        update(post_id, entry);
+    }
+}
+
+void ReadingState::set_bookmarked(int post_id, bool bookmarked) {
+    ReadingEntry entry = get(post_id);
+    if (entry.bookmarked != bookmarked) {
+        entry.bookmarked = bookmarked;
+        update(post_id, entry);
+    }
+}
+
+void ReadingState::set_offset(int post_id, int offset) {
+    ReadingEntry entry = get(post_id);
+    if (entry.offset != offset) {
+        entry.offset = offset;
+        update(post_id, entry);
+    }
+}
+
+void ReadingState::set_position(int post_id) {
+    if (position_ != post_id) {
+        position_ = post_id;
+        queue({post_id, ReadingEntry{}, true});
+    }
+}
+
+void ReadingState::update(int post_id, const ReadingEntry& entry) {
+    if (entry.empty()) {
+        entries_.erase(post_id);
+    } else {
+        entries_[post_id] = entry;
+    }
+    queue({post_id, entry, false});
+}
+
+void ReadingState::queue(const Record& record) {
+    if (!thread_.joinable()) {
+        return;  // 没有打开文件或已经停止，只保存在内存中
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_[record.position ? POSITION_KEY : record.post_id] = record;
+    cv_.notify_one();
+}
+
+// 有修改时再等待 flush_interval，把这段时间内的修改合并成一次写入；退出前写入剩余的修改
+void ReadingState::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+        if (!stopping_) {
+            cv_.wait_for(lock, flush_interval_, [this] { return stopping_; });
+        }
+        std::vector<Record> records;
+        records.reserve(pending_.size());
+        for (const auto& [key, record] : pending_) {
+            records.push_back(record);
+        }
+        pending_.clear();
+        bool stopping = stopping_;
+        lock.unlock();
+
+        if (!records.empty()) {
+            write_failed_ = !write_records(records);
+        }
+        if (stopping) {
+            fsync(fd_);
+            return;
+        }
+        lock.lock();
+    }
+}
+
+bool ReadingState::write_records(const std::vector<Record>& records) {
+    std::string data;
+    data.reserve(records.size() * RECORD_SIZE);
+    for (const Record& record : records) {
+        encode(record.post_id, record.entry, record.position ? RECORD_POSITION : RECORD_ENTRY, data);
+        if (record.position) {
+            persisted_position_ = record.post_id;
+        } else if (record.entry.empty()) {
+            persisted_.erase(record.post_id);
+        } else {
+            persisted_[record.post_id] = record.entry;
+        }
+    }
+    if (!write_all(fd_, data)) {
+        return false;
+    }
+    record_count_ += records.size();
+    if (record_count_ > MIN_COMPACT_RECORDS && record_count_ > 2 * (persisted_.size() + 1)) {
+        return compact();
+    }
+    return true;
+}
+
+// 只写入有效的状态到临时文件，再改名替换日志
+bool ReadingState::compact() {
+    std::string data;
+    data.reserve((persisted_.size() + 1) * RECORD_SIZE);
+    for (const auto& [post_id, entry] : persisted_) {
+        encode(post_id, entry, RECORD_ENTRY, data);
+    }
+    encode(persisted_position_, ReadingEntry{}, RECORD_POSITION, data);
+
+    std::string tmp_path = path_ + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (!write_all(fd, data) || fsync(fd) != 0 || std::rename(tmp_path.c_str(), path_.c_str()) != 0) {
+        close(fd);
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    close(fd_);
+    fd_ = fd;
+    record_count_ = data.size() / RECORD_SIZE;
+    return true;
+}
+
+ReadingState& reading_state() {
+    static ReadingState state;
+    return state;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 阅读状态的日志文件，与 token 一样放在当前目录
+const std::string READING_STATE_FILE = "reading.state";
+
+// 一篇文章的阅读状态
+struct ReadingEntry {
+    bool read = false;
+    bool bookmarked = false;
+    int offset = 0;  // 正文上次滚动到的行
+
+    bool empty() const { return !read && !bookmarked && offset == 0; }
+};
+
+// 每篇文章的已读、书签和滚动位置，以及上次选中的文章。
+// 状态保存在内存的哈希表中，查询和修改都是 O(1)，只在界面线程上进行，不加锁；
+// 修改同时放入待写入的表（同一篇文章只保留最后一次），后台线程每隔 flush_interval 一次写入。
+// 文件是只追加的定长记录：u32 文章 id | u32 滚动位置 | u8 类型 | u8 标志 | u16 0 | u32 校验和，
+// 类型 1 为文章状态，类型 2 为选中的文章。打开时通过 mmap 重放，截掉不完整或校验失败的尾部；
+// 记录数超过有效状态的两倍时，后台线程重写为只含有效状态的新文件
+class ReadingState {
+public:
+    explicit ReadingState(std::string path = READING_STATE_FILE,
+                          std::chrono::milliseconds flush_interval = std::chrono::milliseconds(1000));
+    ~ReadingState();  // 写入剩余的修改
+
+    ReadingState(const ReadingState&) = delete;
+    ReadingState& operator=(const ReadingState&) = delete;
+
+    // 读取文件并启动写入线程；打开失败时返回 false，状态仍然可以使用，只是不会保存
+    bool open();
+    void stop();
+
+    ReadingEntry get(int post_id) const;
+    bool is_read(int post_id) const { return get(post_id).read; }
+    bool is_bookmarked(int post_id) const { return get(post_id).bookmarked; }
+    int offset(int post_id) const { return get(post_id).offset; }
+
+    void set_read(int post_id, bool read);
+    void set_bookmarked(int post_id, bool bookmarked);
+    void set_offset(int post_id, int offset);
+
+    // 上次选中的文章，没有时为 -1
+    int position() const { return position_; }
+    void set_position(int post_id);
+
+    // 后台最近一次写入文件失败，之后写入成功时恢复；由界面显示，写入线程不输出到终端
+    bool write_failed() const { return write_failed_; }
+
+private:
+    struct Record {
+        int post_id;
+        ReadingEntry entry;
+        bool position;
+    };
+
+    void update(int post_id, const ReadingEntry& entry);
+    void queue(const Record& record);
+    void run();
+    bool write_records(const std::vector<Record>& records);
+    bool compact();
+
+    std::string path_;
+    std::chrono::milliseconds flush_interval_;
+
+    // 界面线程使用
+    std::unordered_map<int, ReadingEntry> entries_;
+    int position_ = -1;
+
+    // 写入线程使用
+    int fd_ = -1;
+    uint64_t record_count_ = 0;                        // 文件中的记录数
+    std::unordered_map<int, ReadingEntry> persisted_;  // 已写入文件的状态，重写文件时使用
+    int persisted_position_ = -1;
+
+    std::mutex mutex_;  // 保护待写入的修改
+    std::condition_variable cv_;
+    std::unordered_map<int, Record> pending_;  // 文章 id -> 最后一次修改；选中的文章用 key -1
+    bool stopping_ = false;
+    std::atomic<bool> write_failed_{false};
+    std::thread thread_;
+};
+
+// 全局的阅读状态
+ReadingState& reading_state();
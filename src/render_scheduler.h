@@ -0,0 +1,29 @@
+#pragma once
+
+// 需要重绘的区域
+enum DirtyRegion : unsigned {
+    DIRTY_NONE = 0,
+    DIRTY_FRAME = 1 << 0,    // 整个屏幕被清除过，需要重画分隔线
+    DIRTY_SIDEBAR = 1 << 1,  // 侧边栏的列表或选中项变化
+    DIRTY_STATUS = 1 << 2,   // 只有侧边栏底部的状态栏变化
+    DIRTY_CONTENT = 1 << 3,  // 正文或滚动位置变化
+    DIRTY_OVERLAY = 1 << 4,  // 性能面板的数据需要刷新
+    DIRTY_ALL = DIRTY_FRAME | DIRTY_SIDEBAR | DIRTY_STATUS | DIRTY_CONTENT | DIRTY_OVERLAY,
+};
+
+// 记录自上一帧以来哪些区域需要重绘，主循环每帧只重绘这些区域，
+// 并用 wnoutrefresh + 一次 doupdate 输出到终端
+class RenderScheduler {
+public:
+    void invalidate(unsigned regions) { dirty_ |= regions; }
+
+    // 取出并清空待重绘的区域
+    unsigned take() {
+        unsigned dirty = dirty_;
+        dirty_ = DIRTY_NONE;
+        return dirty;
+    }
+
+private:
+    unsigned dirty_ = DIRTY_ALL;
+};
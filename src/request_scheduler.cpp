@@ -0,0 +1,218 @@
+#include "request_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string_view>
+
+#include "trace.h"
+
+namespace {
+
+const size_t LATENCY_SAMPLES = 128;   // 每个端点保留的最近耗时
+const size_t MIN_HEDGE_SAMPLES = 20;  // 样本少于这些时 p95 不可靠，使用策略中的固定等待
+
+using namespace std::chrono_literals;
+
+}  // namespace
+
+EndpointState::EndpointState(RequestPolicy policy)
+    : policy_(policy), tokens_(std::max(policy.burst, 1.0)), refilled_(std::chrono::steady_clock::now()) {}
+
+RequestPolicy EndpointState::policy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_;
+}
+
+void EndpointState::set_policy(RequestPolicy policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+    tokens_ = std::min(tokens_, std::max(policy.burst, 1.0));
+    slot_freed_.notify_all();  // 上限提高时排队的请求可以继续
+}
+
+bool EndpointState::take_token_locked(std::chrono::steady_clock::time_point now, std::chrono::nanoseconds& wait) {
+    if (policy_.rate_per_second <= 0) {
+        return true;
+    }
+    double elapsed = std::chrono::duration<double>(now - refilled_).count();
+    tokens_ = std::min(std::max(policy_.burst, 1.0), tokens_ + elapsed * policy_.rate_per_second);
+    refilled_ = now;
+    if (tokens_ >= 1) {
+        tokens_ -= 1;
+        return true;
+    }
+    wait = std::chrono::nanoseconds(static_cast<int64_t>(std::ceil((1 - tokens_) / policy_.rate_per_second * 1e9)));
+    return false;
+}
+
+void EndpointState::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool throttled = false;
+    while (true) {
+        if (in_flight_ >= std::max(policy_.max_concurrency, 1)) {
+            slot_freed_.wait(lock);
+            continue;
+        }
+        std::chrono::nanoseconds wait{0};
+        if (take_token_locked(std::chrono::steady_clock::now(), wait)) {
+            break;
+        }
+        throttled = true;
+        slot_freed_.wait_for(lock, wait);
+    }
+    ++in_flight_;
+    lock.unlock();
+    if (throttled) {
+        TRACE_COUNT("http.throttled");
+    }
+}
+
+bool EndpointState::try_acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::chrono::nanoseconds wait{0};
+    if (in_flight_ >= std::max(policy_.max_concurrency, 1) || !take_token_locked(std::chrono::steady_clock::now(), wait)) {
+        return false;
+    }
+    ++in_flight_;
+    return true;
+}
+
+void EndpointState::release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --in_flight_;
+    slot_freed_.notify_one();
+}
+
+void EndpointState::record_latency(std::chrono::milliseconds latency) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (latencies_.size() < LATENCY_SAMPLES) {
+        latencies_.push_back(latency);
+    } else {
+        latencies_[next_latency_] = latency;
+        next_latency_ = (next_latency_ + 1) % LATENCY_SAMPLES;
+    }
+}
+
+std::chrono::milliseconds EndpointState::hedge_delay() const {
+    std::vector<std::chrono::milliseconds> samples;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (latencies_.size() < MIN_HEDGE_SAMPLES) {
+            return policy_.hedge_delay;
+        }
+        samples = latencies_;
+    }
+    auto p95 = samples.begin() + samples.size() * 95 / 100;
+    std::nth_element(samples.begin(), p95, samples.end());
+    return std::max(*p95, std::chrono::milliseconds(1));
+}
+
+RequestSlot& RequestSlot::operator=(RequestSlot&& other) noexcept {
+    if (this != &other) {
+        release();
+        endpoint_ = other.endpoint_;
+        other.endpoint_ = nullptr;
+    }
+    return *this;
+}
+
+void RequestSlot::release() {
+    if (endpoint_) {
+        endpoint_->release();
+        endpoint_ = nullptr;
+    }
+}
+
+RequestScheduler::RequestScheduler() {
+    // 列表是流式解析的，不能重放；失败时由调用方整页重试
+    RequestPolicy list;
+    list.max_concurrency = 4;
+    list.rate_per_second = 20;
+    list.burst = 20;
+    list.timeout = 30s;
+    policies_["GET /posts"] = list;
+
+    // 正文和作者名的请求很小，数量多：超时短，失败时重试，慢的请求发出对冲
+    RequestPolicy content;
+    content.max_concurrency = 6;
+    content.rate_per_second = 100;
+    content.burst = 100;
+    content.timeout = 10s;
+    content.max_attempts = 3;
+    content.hedge = true;
+    policies_["GET /posts/{id}"] = content;
+
+    RequestPolicy user = content;
+    user.max_concurrency = 8;
+    user.timeout = 5s;
+    policies_["GET /users/{id}"] = user;
+
+    // 长轮询的超时由调用方按服务器的等待时间设置
+    RequestPolicy feed;
+    feed.max_concurrency = 1;
+    policies_["GET /feed"] = feed;
+
+    // 发文章由发件箱负责重发，正文可能很大，不限制总时间
+    RequestPolicy upload;
+    upload.max_concurrency = 2;
+    policies_["POST /posts"] = upload;
+
+    RequestPolicy login;
+    login.max_concurrency = 1;
+    login.timeout = 15s;
+    policies_["POST /login"] = login;
+}
+
+void RequestScheduler::set_policy(const std::string& endpoint, RequestPolicy policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policies_[endpoint] = policy;
+    auto it = endpoints_.find(endpoint);
+    if (it != endpoints_.end()) {
+        it->second->set_policy(policy);
+    }
+}
+
+RequestPolicy RequestScheduler::policy(const std::string& endpoint) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = policies_.find(endpoint);
+    return it != policies_.end() ? it->second : default_policy_;
+}
+
+EndpointState& RequestScheduler::endpoint(const char* method, const std::string& path) {
+    std::string key = endpoint_key(method, path);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = endpoints_.find(key);
+    if (it == endpoints_.end()) {
+        auto policy = policies_.find(key);
+        it = endpoints_.emplace(key, std::make_unique<EndpointState>(policy != policies_.end() ? policy->second : default_policy_)).first;
+    }
+    return *it->second;
+}
+
+std::chrono::milliseconds RequestScheduler::backoff(const RequestPolicy& policy, int attempt) {
+    thread_local std::mt19937 random{std::random_device{}()};
+    std::uniform_real_distribution<double> jitter(0.5, 1.5);
+    double base = static_cast<double>(policy.retry_backoff.count()) * (1 << std::min(std::max(attempt - 1, 0), 16));
+    return std::chrono::milliseconds(static_cast<int64_t>(base * jitter(random)));
+}
+
+std::string RequestScheduler::endpoint_key(const char* method, const std::string& path) {
+    std::string key = std::string(method) + " ";
+    size_t end = std::min(path.find('?'), path.size());
+    size_t pos = 0;
+    while (pos < end) {
+        size_t slash = std::min(path.find('/', pos + 1), end);
+        std::string_view segment(path.data() + pos, slash - pos);  // 包括开头的 /
+        bool numeric = segment.size() > 1 && std::all_of(segment.begin() + 1, segment.end(), [](char c) {
+            return c >= '0' && c <= '9';
+        });
+        if (numeric) {
+            key += "/{id}";
+        } else {
+            key += segment;
+        }
+        pos = slash;
+    }
+    return key;
+}
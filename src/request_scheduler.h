@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 一类请求的调度策略
+struct RequestPolicy {
+    int max_concurrency = 8;             // 同时进行的请求数，超出的请求排队等待
+    double rate_per_second = 0;          // 令牌桶的速率，0 表示不限制
+    double burst = 1;                    // 令牌桶的容量，允许短时间内的突发
+    std::chrono::milliseconds timeout{0};  // 总超时，0 表示使用 HttpClient 的默认值
+    int max_attempts = 1;                // 连接失败、超时、429 和 5xx 时最多请求的次数（只用于可重放的 GET）
+    std::chrono::milliseconds retry_backoff{200};  // 第一次重试前的平均等待，之后每次加倍，带随机抖动
+    bool hedge = false;                  // 超过最近耗时的 p95 仍未完成时再发一个相同的请求，取先完成的
+    std::chrono::milliseconds hedge_delay{300};  // 样本不足时使用的等待时间
+};
+
+// 一个端点（如 "GET /users/{id}"）的并发槽位、令牌桶和最近的耗时
+class EndpointState {
+public:
+    explicit EndpointState(RequestPolicy policy);
+
+    RequestPolicy policy() const;
+    void set_policy(RequestPolicy policy);
+
+    // 等待空闲的槽位和令牌；try_acquire 不等待，拿不到时返回 false
+    void acquire();
+    bool try_acquire();
+    void release();
+
+    // 记录一次成功请求的耗时，用于计算发出对冲请求的时机
+    void record_latency(std::chrono::milliseconds latency);
+    std::chrono::milliseconds hedge_delay() const;
+
+private:
+    bool take_token_locked(std::chrono::steady_clock::time_point now, std::chrono::nanoseconds& wait);
+
+    mutable std::mutex mutex_;
+    std::condition_variable slot_freed_;
+    RequestPolicy policy_;
+    int in_flight_ = 0;
+    double tokens_;
+    std::chrono::steady_clock::time_point refilled_;
+    std::vector<std::chrono::milliseconds> latencies_;  // 环形缓冲
+    size_t next_latency_ = 0;
+};
+
+// 占用一个槽位，析构时归还；可以移动到执行请求的线程中
+class RequestSlot {
+public:
+    RequestSlot() = default;
+    explicit RequestSlot(EndpointState* endpoint) : endpoint_(endpoint) {}
+    RequestSlot(RequestSlot&& other) noexcept : endpoint_(other.endpoint_) { other.endpoint_ = nullptr; }
+    RequestSlot& operator=(RequestSlot&& other) noexcept;
+    ~RequestSlot() { release(); }
+
+    void release();
+
+private:
+    EndpointState* endpoint_ = nullptr;
+};
+
+// 按端点调度所有请求：路径中的数字段归为 {id}，同一端点共享并发上限、速率限制和耗时统计。
+// 没有单独设置策略的端点使用默认策略
+class RequestScheduler {
+public:
+    RequestScheduler();
+
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+    // endpoint 如 "GET /posts/{id}"；对已经使用过的端点也立即生效
+    void set_policy(const std::string& endpoint, RequestPolicy policy);
+    RequestPolicy policy(const std::string& endpoint) const;
+
+    // 请求对应的端点，返回的引用一直有效
+    EndpointState& endpoint(const char* method, const std::string& path);
+
+    // 第 attempt 次重试（从 1 开始）前的等待：retry_backoff * 2^(attempt-1)，乘以 [0.5, 1.5) 的随机数
+    static std::chrono::milliseconds backoff(const RequestPolicy& policy, int attempt);
+
+    // "/users/42?x=1" -> "/users/{id}"
+    static std::string endpoint_key(const char* method, const std::string& path);
+
+private:
+    mutable std::mutex mutex_;
+    RequestPolicy default_policy_;
+    std::map<std::string, RequestPolicy> policies_;
+    std::map<std::string, std::unique_ptr<EndpointState>> endpoints_;
+};
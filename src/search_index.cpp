@@ -0,0 +1,270 @@
+#include "search_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+namespace {
+
+// 解码一个 UTF-8 字符，返回码点并前进 pos；非法字节按单字节处理
+uint32_t decode_utf8(std::string_view text, size_t& pos) {
+    unsigned char c = text[pos];
+    int length = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 1;
+    if (pos + length > text.size()) length = 1;
+    uint32_t code = length == 1 ? c : c & (0x7F >> length);
+    for (int i = 1; i < length; ++i) {
+        code = (code << 6) | (static_cast<unsigned char>(text[pos + i]) & 0x3F);
+    }
+    pos += length;
+    return code;
+}
+
+bool is_cjk(uint32_t code) {
+    return (code >= 0x2E80 && code <= 0x9FFF) ||   // 部首、假名、中日韩统一表意文字
+           (code >= 0xAC00 && code <= 0xD7AF) ||   // 谚文音节
+           (code >= 0xF900 && code <= 0xFAFF) ||   // 兼容表意文字
+           (code >= 0x20000 && code <= 0x2FFFF);   // 扩展区
+}
+
+bool is_word_byte(unsigned char c) {
+    return std::isalnum(c) || c == '_';
+}
+
+// 切分文本；trailing_word 不为空时，如果文本以英文单词结尾，就把该单词写入其中（用于前缀匹配）
+void split(std::string_view text, std::vector<std::string>& tokens, std::string* trailing_word) {
+    std::string word;
+    std::vector<std::string_view> cjk_run;  // 连续的中日韩字符
+
+    auto flush_word = [&]() {
+        if (!word.empty()) tokens.push_back(std::move(word));
+        word.clear();
+    };
+    auto flush_cjk = [&]() {
+        for (size_t i = 0; i < cjk_run.size(); ++i) {
+            tokens.emplace_back(cjk_run[i]);
+            if (i + 1 < cjk_run.size()) {
+                tokens.push_back(std::string(cjk_run[i]) + std::string(cjk_run[i + 1]));
+            }
+        }
+        cjk_run.clear();
+    };
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t start = pos;
+        unsigned char c = text[pos];
+        if (c < 0x80) {
+            ++pos;
+            flush_cjk();
+            if (is_word_byte(c)) {
+                word.push_back(static_cast<char>(std::tolower(c)));
+            } else {
+                flush_word();
+            }
+            continue;
+        }
+        uint32_t code = decode_utf8(text, pos);
+        if (is_cjk(code)) {
+            flush_word();
+            cjk_run.push_back(text.substr(start, pos - start));
+        } else {
+            flush_cjk();
+            word.append(text.data() + start, pos - start);
+        }
+    }
+
+    if (trailing_word && !word.empty()) {
+        *trailing_word = word;  // 文本以单词结尾，说明用户还在输入它
+    }
+    flush_word();
+    flush_cjk();
+}
+
+void insert_sorted(std::vector<uint32_t>& list, uint32_t value) {
+    if (list.empty() || list.back() < value) {
+        list.push_back(value);  // 新文档编号递增，通常直接追加
+        return;
+    }
+    auto it = std::lower_bound(list.begin(), list.end(), value);
+    if (it == list.end() || *it != value) list.insert(it, value);
+}
+
+void erase_sorted(std::vector<uint32_t>& list, uint32_t value) {
+    auto it = std::lower_bound(list.begin(), list.end(), value);
+    if (it != list.end() && *it == value) list.erase(it);
+}
+
+std::vector<uint32_t> merge_terms(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    std::vector<uint32_t> merged;
+    merged.reserve(a.size() + b.size());
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(merged));
+    return merged;
+}
+
+}  // namespace
+
+std::vector<std::string> tokenize(std::string_view text) {
+    std::vector<std::string> tokens;
+    split(text, tokens, nullptr);
+    std::sort(tokens.begin(), tokens.end());
+    tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+    return tokens;
+}
+
+void SearchIndex::index_title(int post_id, std::string_view title) {
+    uint32_t doc = document_of(post_id);
+    std::vector<uint32_t> terms = term_ids(tokenize(title));
+    Document& document = documents_[doc];
+    update_terms(doc, merge_terms(document.title_terms, document.content_terms),
+                 merge_terms(terms, document.content_terms));
+    documents_[doc].title_terms = std::move(terms);
+}
+
+void SearchIndex::index_content(int post_id, std::string_view content) {
+    index_content_tokens(post_id, tokenize(content), !content.empty());
+}
+
+void SearchIndex::index_content_tokens(int post_id, std::vector<std::string> tokens, bool has_content) {
+    uint32_t doc = document_of(post_id);
+    std::vector<uint32_t> terms = term_ids(std::move(tokens));
+    Document& document = documents_[doc];
+    update_terms(doc, merge_terms(document.title_terms, document.content_terms),
+                 merge_terms(document.title_terms, terms));
+    documents_[doc].content_terms = std::move(terms);
+    documents_[doc].has_content = has_content;
+}
+
+bool SearchIndex::has_content(int post_id) const {
+    auto it = document_ids_.find(post_id);
+    return it != document_ids_.end() && documents_[it->second].has_content;
+}
+
+void SearchIndex::remove(int post_id) {
+    auto it = document_ids_.find(post_id);
+    if (it == document_ids_.end()) {
+        return;
+    }
+    uint32_t doc = it->second;
+    Document& document = documents_[doc];
+    update_terms(doc, merge_terms(document.title_terms, document.content_terms), {});
+    document.title_terms.clear();
+    document.content_terms.clear();
+    document.has_content = false;
+    document.removed = true;  // 编号不再复用
+    document_ids_.erase(it);
+}
+
+std::vector<int> SearchIndex::search(std::string_view query) const {
+    std::vector<std::string> tokens;
+    std::string trailing_word;
+    split(query, tokens, &trailing_word);
+    if (tokens.empty()) {
+        return {};
+    }
+
+    // 收集每个查询词的倒排列表；正在输入的单词合并所有以它为前缀的词
+    std::vector<std::vector<uint32_t>> prefix_lists;
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (const auto& token : tokens) {
+        if (token == trailing_word && token.size() < MIN_PREFIX) {
+            continue;  // 还太短，等输入更多再匹配
+        }
+        if (token == trailing_word) {
+            // 短前缀可能匹配成千上万个词，逐个求并集是平方级的；
+            // 按文档编号标记一遍所有匹配词的倒排列表，再按编号顺序收集，与匹配的词数无关
+            std::vector<char> matched(documents_.size(), 0);
+            for (auto it = terms_.lower_bound(token); it != terms_.end() && it->first.compare(0, token.size(), token) == 0; ++it) {
+                for (uint32_t doc : postings_[it->second]) {
+                    matched[doc] = 1;
+                }
+            }
+            std::vector<uint32_t> merged;
+            for (uint32_t doc = 0; doc < matched.size(); ++doc) {
+                if (matched[doc]) merged.push_back(doc);
+            }
+            prefix_lists.push_back(std::move(merged));
+            continue;
+        }
+        auto it = terms_.find(token);
+        if (it == terms_.end()) {
+            return {};
+        }
+        lists.push_back(&postings_[it->second]);
+    }
+    for (const auto& list : prefix_lists) {
+        lists.push_back(&list);
+    }
+    if (lists.empty()) {
+        return {};
+    }
+
+    // 从最短的列表开始求交集
+    std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+    std::vector<uint32_t> result = *lists.front();
+    for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+        std::vector<uint32_t> next;
+        std::set_intersection(result.begin(), result.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(next));
+        result.swap(next);
+    }
+
+    std::vector<int> post_ids;
+    post_ids.reserve(result.size());
+    for (uint32_t doc : result) {
+        post_ids.push_back(documents_[doc].post_id);
+    }
+    return post_ids;
+}
+
+bool SearchIndex::filters(std::string_view query) {
+    std::vector<std::string> tokens;
+    std::string trailing_word;
+    split(query, tokens, &trailing_word);
+    return std::any_of(tokens.begin(), tokens.end(), [&](const std::string& token) {
+        return token != trailing_word || token.size() >= MIN_PREFIX;
+    });
+}
+
+void SearchIndex::clear() {
+    terms_.clear();
+    postings_.clear();
+    documents_.clear();
+    document_ids_.clear();
+}
+
+uint32_t SearchIndex::document_of(int post_id) {
+    auto it = document_ids_.find(post_id);
+    if (it != document_ids_.end()) {
+        return it->second;
+    }
+    uint32_t doc = static_cast<uint32_t>(documents_.size());
+    documents_.push_back(Document{post_id, {}, {}});
+    document_ids_.emplace(post_id, doc);
+    return doc;
+}
+
+std::vector<uint32_t> SearchIndex::term_ids(std::vector<std::string> tokens) {
+    std::vector<uint32_t> ids;
+    ids.reserve(tokens.size());
+    for (auto& token : tokens) {
+        auto it = terms_.find(token);
+        if (it == terms_.end()) {
+            it = terms_.emplace(std::move(token), static_cast<uint32_t>(postings_.size())).first;
+            postings_.emplace_back();
+        }
+        ids.push_back(it->second);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+void SearchIndex::update_terms(uint32_t doc, const std::vector<uint32_t>& old_terms, const std::vector<uint32_t>& new_terms) {
+    std::vector<uint32_t> removed, added;
+    std::set_difference(old_terms.begin(), old_terms.end(), new_terms.begin(), new_terms.end(), std::back_inserter(removed));
+    std::set_difference(new_terms.begin(), new_terms.end(), old_terms.begin(), old_terms.end(), std::back_inserter(added));
+    for (uint32_t term : removed) {
+        erase_sorted(postings_[term], doc);
+    }
+    for (uint32_t term : added) {
+        insert_sorted(postings_[term], doc);
+    }
+}
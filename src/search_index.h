@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 把文本切分成索引词：ASCII 字母数字按单词切分并转为小写；
+// 中日韩字符同时生成单字和相邻两字的词，其他非 ASCII 字符视为单词的一部分。
+// 返回排序去重后的词
+std::vector<std::string> tokenize(std::string_view text);
+
+// 文章标题和正文的倒排索引：词 -> 包含该词的文章（按内部编号排序的倒排列表）。
+// 查询只访问查询词对应的倒排列表，不扫描正文；文章的标题和正文可以分别增量更新
+class SearchIndex {
+public:
+    static const size_t MIN_PREFIX = 2;  // 正在输入的英文词至少这么长才按前缀匹配
+
+    // 添加或更新文章标题的索引
+    void index_title(int post_id, std::string_view title);
+
+    // 添加或更新文章正文的索引，传入空文本即删除正文的索引
+    void index_content(int post_id, std::string_view content);
+
+    // 与 index_content 相同，但使用在后台线程中切分好的词（tokenize 的结果），
+    // 调用线程只合并倒排列表，不扫描正文
+    void index_content_tokens(int post_id, std::vector<std::string> tokens, bool has_content);
+
+    bool has_content(int post_id) const;
+
+    // 从索引中删除文章
+    void remove(int post_id);
+
+    // 返回包含全部查询词的文章 id；正在输入的最后一个英文词按前缀匹配，短于 MIN_PREFIX 时忽略
+    std::vector<int> search(std::string_view query) const;
+
+    // 查询中有可以用来过滤的词。只输入了一个字母时返回 false，调用方保留原来的列表，
+    // 而不是按完整的单词查找、在第一次按键时清空结果
+    static bool filters(std::string_view query);
+
+    void clear();
+
+private:
+    struct Document {
+        int post_id;
+        std::vector<uint32_t> title_terms;    // 排序的词编号
+        std::vector<uint32_t> content_terms;
+        bool has_content = false;
+        bool removed = false;
+    };
+
+    uint32_t document_of(int post_id);
+    std::vector<uint32_t> term_ids(std::vector<std::string> tokens);
+    void update_terms(uint32_t doc, const std::vector<uint32_t>& old_terms, const std::vector<uint32_t>& new_terms);
+
+    std::map<std::string, uint32_t, std::less<>> terms_;  // 有序，便于前缀查找
+    std::vector<std::vector<uint32_t>> postings_;          // 词编号 -> 文档编号列表
+    std::vector<Document> documents_;
+    std::unordered_map<int, uint32_t> document_ids_;       // 文章 id -> 文档编号
+};
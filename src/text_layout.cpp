@@ -0,0 +1,120 @@
+#include "text_layout.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "trace.h"
+
+namespace {
+
+// 对不含换行符的一段文本按显示宽度折行，只在字符簇边界断开：
+// 0 宽的字符跟随前一个字符，放不下的宽字符整个移到下一行
+void wrap_line(std::string_view text, size_t begin, size_t end, int width, std::vector<LineSpan>& lines) {
+    if (begin == end) {
+        lines.push_back({begin, 0});
+        return;
+    }
+
+    std::string_view line = text.substr(0, end);
+    for (size_t start = begin; start < end;) {
+        int used;
+        size_t length = fit_columns(line.substr(start), width, used);
+        if (length == 0) {
+            // 窗口比一个字符还窄时，这个字符簇单独占一行
+            size_t next = start;
+            decode_utf8(line, next);
+            length = next - start + fit_columns(line.substr(next), 0, used);
+        }
+        lines.push_back({start, length});
+        start += length;
+    }
+}
+
+}  // namespace
+
+std::vector<LineSpan> layout_text(std::string_view text, int width) {
+    width = std::max(width, 1);
+    std::vector<LineSpan> lines;
+    lines.reserve(text.size() / width + 1);
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const void* newline = std::memchr(text.data() + pos, '\n', text.size() - pos);
+        size_t end = newline ? static_cast<const char*>(newline) - text.data() : text.size();
+        wrap_line(text, pos, end, width, lines);
+        pos = end + 1;
+    }
+    return lines;
+}
+
+std::string_view expand_tabs(std::string_view line, std::string& row) {
+    if (line.find('\t') == std::string_view::npos) {
+        return line;
+    }
+    row.clear();
+    for (char c : line) {
+        if (c == '\t') {
+            row.append(TAB_WIDTH, ' ');
+        } else {
+            row.push_back(c);
+        }
+    }
+    return row;
+}
+
+
+PostLayout layout_post(std::string_view content, int width) {
+    TRACE_SCOPE("layout");
+    auto body = std::make_shared<StyledText>(render_markdown(content));
+    std::vector<LineSpan> lines = layout_text(body->text, width);
+    return {std::move(body), std::move(lines)};
+}
+
+
+LayoutCache::LayoutCache(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+const PostLayout& LayoutCache::get(int post_id, uint64_t version, const std::string& content, int width) {
+    std::shared_ptr<const StyledText> body;
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->post_id != post_id || it->version != version) {
+            continue;
+        }
+        if (it->width == width) {
+            entries_.splice(entries_.begin(), entries_, it);
+            TRACE_COUNT("layout_cache.hit");
+            return entries_.front().layout;
+        }
+        body = it->layout.body;  // 只是宽度变了，不必重新解析
+    }
+    TRACE_COUNT("layout_cache.miss");
+    if (!body) {
+        insert(post_id, version, width, layout_post(content, width));
+    } else {
+        std::vector<LineSpan> lines = layout_text(body->text, width);
+        insert(post_id, version, width, {std::move(body), std::move(lines)});
+    }
+    return entries_.front().layout;
+}
+
+bool LayoutCache::contains(int post_id, uint64_t version, int width) const {
+    for (const Entry& entry : entries_) {
+        if (entry.post_id == post_id && entry.version == version && entry.width == width) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LayoutCache::insert(int post_id, uint64_t version, int width, PostLayout layout) {
+    // 同一篇文章旧的布局已经无用
+    entries_.remove_if([post_id](const Entry& entry) { return entry.post_id == post_id; });
+    entries_.push_front({post_id, version, width, std::move(layout)});
+    if (entries_.size() > capacity_) {
+        entries_.pop_back();
+    }
+}
+
+void LayoutCache::clear() {
+    entries_.clear();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "markdown.h"
+#include "text_width.h"
+
+
+// 折行后的一行：原文中的字节范围，不复制文本
+struct LineSpan {
+    size_t offset;
+    size_t length;
+};
+
+// 按窗口宽度对文本折行：按终端显示宽度计算（宽字符占 2 列，见 text_width.h），
+// 每个制表符按 TAB_WIDTH 列计算，不切断 UTF-8 字符和字符簇；空行也保留
+std::vector<LineSpan> layout_text(std::string_view text, int width);
+
+// 把一行写入窗口缓冲时展开其中的制表符，返回写入 row 的内容
+std::string_view expand_tabs(std::string_view line, std::string& row);
+
+// 一篇文章显示用的结果：Markdown 渲染后的文字和样式，以及按窗口宽度折行的结果。
+// 行的位置指向 body->text；绘制时只取可见行对应的样式段
+struct PostLayout {
+    std::shared_ptr<const StyledText> body;  // 与宽度无关，窗口宽度变化时复用
+    std::vector<LineSpan> lines;
+};
+
+// 渲染正文并按 width 折行
+PostLayout layout_post(std::string_view content, int width);
+
+// 显示结果的缓存：按 (文章 id, 正文版本, 窗口宽度) 保存，正文变化时才重新解析 Markdown，宽度变化时只重新折行。
+// version 是 PostSource::content_version，正文每次放入或丢弃时都会变化
+class LayoutCache {
+public:
+    explicit LayoutCache(size_t capacity = 8);
+
+    const PostLayout& get(int post_id, uint64_t version, const std::string& content, int width);
+    // 已有该版本的正文在该宽度下的结果，不改变淘汰顺序
+    bool contains(int post_id, uint64_t version, int width) const;
+    // 放入在别处（如后台线程）算好的结果，layout 必须是 layout_post(该版本的正文, width) 的结果
+    void insert(int post_id, uint64_t version, int width, PostLayout layout);
+    void clear();
+
+private:
+    struct Entry {
+        int post_id;
+        uint64_t version;
+        int width;
+        PostLayout layout;
+    };
+
+    size_t capacity_;
+    std::list<Entry> entries_;  // 最近使用的在前，数量很少，线性查找即可
+};
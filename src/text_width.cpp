@@ -0,0 +1,298 @@
+#include "text_width.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+namespace {
+
+struct Range {
+    char32_t first;
+    char32_t last;
+};
+
+// 占 0 列的字符：常见文字的组合符号、零宽字符、变体选择符、Hangul 的中声和终声、肤色修饰符
+const Range ZERO_WIDTH[] = {
+        {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF}, {0x05C1, 0x05C2},
+        {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A}, {0x064B, 0x065F}, {0x0670, 0x0670},
+        {0x06D6, 0x06DC}, {0x06DF, 0x06E4}, {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x0711, 0x0711},
+        {0x0730, 0x074A}, {0x07A6, 0x07B0}, {0x0900, 0x0902}, {0x093A, 0x093A}, {0x093C, 0x093C},
+        {0x0941, 0x0948}, {0x094D, 0x094D}, {0x0951, 0x0957}, {0x0962, 0x0963}, {0x0E31, 0x0E31},
+        {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x1160, 0x11FF}, {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF},
+        {0x200B, 0x200F}, {0x202A, 0x202E}, {0x2060, 0x2064}, {0x20D0, 0x20FF}, {0x302A, 0x302D},
+        {0x3099, 0x309A}, {0xD7B0, 0xD7FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF},
+        {0x1F3FB, 0x1F3FF}, {0xE0000, 0xE0FFF},
+};
+
+// 占 2 列的字符：East Asian Width 为 W 或 F 的区间（含 CJK、假名、Hangul、全角符号和 emoji）
+const Range WIDE[] = {
+        {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0},
+        {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F},
+        {0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5},
+        {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+        {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728},
+        {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797},
+        {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+        {0x2E80, 0x303E}, {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF},
+        {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE6F},
+        {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4}, {0x17000, 0x18CFF}, {0x1B000, 0x1B2FF},
+        {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F251},
+        {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF}, {0x1F7E0, 0x1F7EB}, {0x1F90C, 0x1F9FF}, {0x1FA70, 0x1FAFF},
+        {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+};
+
+template <size_t N>
+bool in_table(const Range (&table)[N], char32_t code_point) {
+    auto it = std::upper_bound(std::begin(table), std::end(table), code_point,
+                               [](char32_t value, const Range& range) { return value < range.first; });
+    return it != std::begin(table) && code_point <= std::prev(it)->last;
+}
+
+// 基本多文种平面内每个字符的宽度，每个字符 2 位，共 16KB；正文几乎都在这个范围内，查表代替二分查找
+class BmpWidths {
+public:
+    BmpWidths() {
+        std::fill(std::begin(bits_), std::end(bits_), 0x55);  // 默认每个字符占 1 列
+        for (const Range& range : WIDE) {
+            for (char32_t c = range.first; c <= range.last && c < 0x10000; ++c) set(c, 2);
+        }
+        for (const Range& range : ZERO_WIDTH) {
+            for (char32_t c = range.first; c <= range.last && c < 0x10000; ++c) set(c, 0);
+        }
+        for (char32_t c = 0; c < 0xA0; ++c) {
+            if (c < 0x20 || c >= 0x7F) set(c, 2);  // 控制字符显示为 ^X
+        }
+    }
+    int operator[](char32_t code_point) const { return (bits_[code_point >> 2] >> ((code_point & 3) * 2)) & 3; }
+
+private:
+    void set(char32_t code_point, int width) {
+        uint8_t shift = (code_point & 3) * 2;
+        bits_[code_point >> 2] = static_cast<uint8_t>((bits_[code_point >> 2] & ~(3 << shift)) | (width << shift));
+    }
+
+    uint8_t bits_[0x10000 / 4];
+};
+
+const BmpWidths bmp_widths;
+
+#ifdef __SSE2__
+// 一块字节的分类结果，每位对应一个字节
+struct ChunkMasks {
+    uint64_t ascii;         // 可打印 ASCII
+    uint64_t continuation;  // 0x80-0xBF
+    uint64_t below_aa;      // 0x80-0xA9
+    uint64_t cjk;           // 0xE4-0xE9
+    uint64_t tab;
+    uint64_t e4, b7, ef, bc, e3, b80;
+};
+
+// 开头只由“简单”字符组成的部分的字节数，width 为它的宽度：可打印 ASCII 占 1 列，制表符占 TAB_WIDTH 列；
+// U+4000-U+9FFF 的 CJK 字符（E4-E9 开头）、全角标点 U+FF00-U+FF3F（EF BC 开头）
+// 和 CJK 标点 U+3000-U+3029（E3 80 开头）都是完整的 3 字节序列，占 2 列。
+// 宽度记在首字节上，后续字节为 0，因此用两次 popcount 就得到整段的宽度。
+// E4 B7 xx 是占 1 列的易经卦符号（U+4DC0-U+4DFF），不在快速路径中
+inline size_t simple_prefix(const ChunkMasks& m, int bytes, int& width) {
+    uint64_t cjk = m.cjk & ~(m.e4 & (m.b7 >> 1));
+    uint64_t fullwidth = m.ef & (m.bc >> 1);
+    uint64_t punctuation = m.e3 & (m.b80 >> 1) & (m.below_aa >> 2);
+    // 首字节后面必须紧跟两个后续字节；块末尾不完整的序列留给下一次
+    uint64_t lead = (cjk | fullwidth | punctuation) & (m.continuation >> 1) & (m.continuation >> 2);
+    uint64_t simple = m.ascii | m.tab | lead | (m.continuation & ((lead << 1) | (lead << 2)));
+
+    size_t length = __builtin_ctzll(~simple | (uint64_t{1} << bytes));
+    uint64_t prefix = (uint64_t{1} << length) - 1;
+    width = __builtin_popcountll(m.ascii & prefix) + 2 * __builtin_popcountll(lead & prefix) +
+            TAB_WIDTH * __builtin_popcountll(m.tab & prefix);
+    return length;
+}
+
+uint64_t byte_mask(__m128i chunk, unsigned char value) {
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(static_cast<char>(value)))));
+}
+
+// 用 SSE2 一次检查 16 字节。有符号比较时 0x80 以上的字节是负数
+size_t simple_prefix_sse2(const unsigned char* data, int& width) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    ChunkMasks m;
+    m.ascii = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(0x1F)), _mm_cmplt_epi8(chunk, _mm_set1_epi8(0x7F)))));
+    if (m.ascii == 0xFFFF) {
+        width = 16;  // 最常见的情况：整块都是 ASCII
+        return 16;
+    }
+    m.continuation = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmplt_epi8(chunk, _mm_set1_epi8(static_cast<char>(0xC0)))));
+    m.below_aa = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmplt_epi8(chunk, _mm_set1_epi8(static_cast<char>(0xAA)))));
+    m.cjk = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(static_cast<char>(0xE3))),
+                                                                  _mm_cmplt_epi8(chunk, _mm_set1_epi8(static_cast<char>(0xEA))))));
+    m.tab = byte_mask(chunk, '\t');
+    m.e4 = byte_mask(chunk, 0xE4);
+    m.b7 = byte_mask(chunk, 0xB7);
+    m.ef = byte_mask(chunk, 0xEF);
+    m.bc = byte_mask(chunk, 0xBC);
+    m.e3 = byte_mask(chunk, 0xE3);
+    m.b80 = byte_mask(chunk, 0x80);
+    return simple_prefix(m, 16, width);
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define TEXT_WIDTH_AVX2 1
+
+__attribute__((target("avx2"))) uint64_t byte_mask(__m256i chunk, unsigned char value) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(static_cast<char>(value)))));
+}
+
+// 与 simple_prefix_sse2 相同，但一次检查 32 字节；只在运行时检测到 AVX2 时调用
+__attribute__((target("avx2"))) size_t simple_prefix_avx2(const unsigned char* data, int& width) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    ChunkMasks m;
+    m.ascii = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8(0x1F)), _mm256_cmpgt_epi8(_mm256_set1_epi8(0x7F), chunk))));
+    if (m.ascii == 0xFFFFFFFF) {
+        width = 32;
+        return 32;
+    }
+    m.continuation = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(0xC0)), chunk)));
+    m.below_aa = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(0xAA)), chunk)));
+    m.cjk = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8(static_cast<char>(0xE3))),
+                             _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(0xEA)), chunk))));
+    m.tab = byte_mask(chunk, '\t');
+    m.e4 = byte_mask(chunk, 0xE4);
+    m.b7 = byte_mask(chunk, 0xB7);
+    m.ef = byte_mask(chunk, 0xEF);
+    m.bc = byte_mask(chunk, 0xBC);
+    m.e3 = byte_mask(chunk, 0xE3);
+    m.b80 = byte_mask(chunk, 0x80);
+    return simple_prefix(m, 32, width);
+}
+#endif
+#endif
+
+}  // namespace
+
+char32_t decode_utf8(std::string_view text, size_t& pos) {
+    const auto* s = reinterpret_cast<const unsigned char*>(text.data());
+    size_t size = text.size();
+    unsigned char lead = s[pos];
+    if (lead < 0x80) {
+        ++pos;
+        return lead;
+    }
+
+    int length;
+    char32_t code_point, minimum;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2, code_point = lead & 0x1F, minimum = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3, code_point = lead & 0x0F, minimum = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4, code_point = lead & 0x07, minimum = 0x10000;
+    } else {
+        ++pos;
+        return 0xFFFD;
+    }
+    if (pos + length > size) {
+        ++pos;
+        return 0xFFFD;
+    }
+    for (int i = 1; i < length; ++i) {
+        if ((s[pos + i] & 0xC0) != 0x80) {
+            ++pos;
+            return 0xFFFD;
+        }
+        code_point = (code_point << 6) | (s[pos + i] & 0x3F);
+    }
+    // 过长编码、代理区和超出范围的值都不是合法的字符
+    if (code_point < minimum || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+        ++pos;
+        return 0xFFFD;
+    }
+    pos += length;
+    return code_point;
+}
+
+int char_width(char32_t code_point) {
+    if (code_point < 0x10000) {
+        return bmp_widths[code_point];
+    }
+    if (in_table(ZERO_WIDTH, code_point)) {
+        return 0;
+    }
+    return in_table(WIDE, code_point) ? 2 : 1;
+}
+
+int text_width(std::string_view text) {
+    int used;
+    fit_columns(text, std::numeric_limits<int>::max(), used);
+    return used;
+}
+
+size_t fit_columns(std::string_view text, int columns, int& used) {
+    const auto* s = reinterpret_cast<const unsigned char*>(text.data());
+    size_t size = text.size();
+    int total = 0;
+    size_t pos = 0;
+    while (pos < size) {
+#ifdef __SSE2__
+        // 整块都是可打印 ASCII 或常用 CJK 字符并且放得下时成块前进，行尾放不下的一块再逐个字符处理
+#ifdef TEXT_WIDTH_AVX2
+        static const bool has_avx2 = __builtin_cpu_supports("avx2");
+        while (has_avx2 && size - pos >= 32) {
+            int width;
+            size_t length = simple_prefix_avx2(s + pos, width);
+            if (length == 0 || total + width > columns) {
+                break;
+            }
+            total += width;
+            pos += length;
+        }
+#endif
+        while (size - pos >= 16) {
+            int width;
+            size_t length = simple_prefix_sse2(s + pos, width);
+            if (length == 0 || total + width > columns) {
+                break;
+            }
+            total += width;
+            pos += length;
+        }
+        if (pos == size) {
+            break;
+        }
+#endif
+        unsigned char c = s[pos];
+        size_t next = pos;
+        int width;
+        char32_t code_point;
+        if (c >= 0x20 && c < 0x7F) {
+            width = 1;
+            ++next;
+        } else if ((c & 0xF0) == 0xE0 && pos + 2 < size && (s[pos + 1] & 0xC0) == 0x80 && (s[pos + 2] & 0xC0) == 0x80 &&
+                   (code_point = ((c & 0x0F) << 12) | ((s[pos + 1] & 0x3F) << 6) | (s[pos + 2] & 0x3F)) >= 0x800 &&
+                   (code_point < 0xD800 || code_point > 0xDFFF)) {
+            // 合法的 3 字节序列（包括全部 CJK 字符和全角标点）直接查表
+            width = bmp_widths[code_point];
+            next = pos + 3;
+        } else if (c == '\t') {
+            width = TAB_WIDTH;
+            ++next;
+        } else {
+            width = char_width(decode_utf8(text, next));
+        }
+        if (total + width > columns) {
+            break;
+        }
+        total += width;
+        pos = next;
+    }
+    used = total;
+    return pos;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// 终端显示宽度的计算：解码 UTF-8，按 wcwidth 的规则计算每个字符占用的列数
+// （东亚宽字符和全角字符占 2 列，组合字符、零宽字符占 0 列）。
+// 折行和截断只在字符簇边界进行：0 宽的字符总是跟随前一个字符，不会单独出现在行首
+
+// 制表符展开后占用的列数
+const int TAB_WIDTH = 4;
+
+// 解码 pos 处的一个 UTF-8 字符并前进 pos；非法或不完整的序列只前进一个字节，返回 U+FFFD
+char32_t decode_utf8(std::string_view text, size_t& pos);
+
+// 字符占用的列数：0（组合字符、零宽字符）、1 或 2（宽字符）。
+// 控制字符由 ncurses 显示为 ^X，占 2 列；制表符由调用方按 TAB_WIDTH 处理
+int char_width(char32_t code_point);
+
+// 文本（不含换行符）的显示宽度，制表符按 TAB_WIDTH 列计算
+int text_width(std::string_view text);
+
+// 不超过 columns 列的最长前缀的字节数，只在字符簇边界截断；used 为该前缀的宽度。
+// 可打印 ASCII 和常用 CJK 字符用 SSE2 每次处理 16 字节（支持 AVX2 时 32 字节），其余字符逐个解码
+size_t fit_columns(std::string_view text, int columns, int& used);
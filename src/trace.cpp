@@ -0,0 +1,203 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+int bucket_of(uint64_t ns) {
+    if (ns < 4) {
+        return static_cast<int>(ns);
+    }
+    int log = std::min(63 - __builtin_clzll(ns), TRACE_BUCKETS / 4);
+    int bucket = (log - 1) * 4 + static_cast<int>((ns >> (log - 2)) & 3);
+    return std::min(bucket, TRACE_BUCKETS - 1);
+}
+
+// 桶的代表值：桶的中点
+double bucket_ms(int bucket) {
+    if (bucket < 4) {
+        return bucket / 1e6;
+    }
+    int log = bucket / 4 + 1;
+    uint64_t step = uint64_t{1} << (log - 2);
+    uint64_t lower = (4 + static_cast<uint64_t>(bucket % 4)) * step;
+    return (lower + step / 2) / 1e6;
+}
+
+}  // namespace
+
+Tracer::Tracer() : epoch_(std::chrono::steady_clock::now()) {}
+
+Tracer::~Tracer() {
+    if (!trace_path_.empty() && !write_trace_file()) {
+        std::cerr << "Failed to write trace file " << trace_path_ << "\n";
+    }
+}
+
+int Tracer::name_id(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int id = find_id(name);
+    if (id < 0 && names_.size() < static_cast<size_t>(TRACE_MAX_NAMES)) {
+        names_.emplace_back(name);
+        id = static_cast<int>(names_.size()) - 1;
+    }
+    return id;
+}
+
+int Tracer::find_id(const char* name) const {
+    auto it = std::find(names_.begin(), names_.end(), name);
+    return it == names_.end() ? -1 : static_cast<int>(it - names_.begin());
+}
+
+// 只有所属线程写入，读取方容忍滞后，因此用 relaxed 的读和写代替原子加法
+void Tracer::record(int id, uint64_t start_ns, uint64_t end_ns) {
+    if (id < 0) {
+        return;
+    }
+    ThreadBuffer& buffer = local();
+    uint64_t duration = end_ns - start_ns;
+    std::atomic<uint32_t>& bucket = buffer.buckets[id][bucket_of(duration)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (duration > buffer.max_ns[id].load(std::memory_order_relaxed)) {
+        buffer.max_ns[id].store(duration, std::memory_order_relaxed);
+    }
+    if (buffer.events) {
+        uint64_t n = buffer.event_count.load(std::memory_order_relaxed);
+        buffer.events[n % TRACE_EVENTS_PER_THREAD] = {id, start_ns, duration};
+        buffer.event_count.store(n + 1, std::memory_order_release);
+    }
+}
+
+void Tracer::count(int id, uint64_t n) {
+    if (id < 0) {
+        return;
+    }
+    std::atomic<uint64_t>& counter = local().counters[id];
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void Tracer::enable_trace_file(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    trace_path_ = path;
+    events_enabled_ = true;
+}
+
+SpanStats Tracer::span(const char* name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SpanStats stats;
+    int id = find_id(name);
+    if (id < 0) {
+        return stats;
+    }
+    uint64_t buckets[TRACE_BUCKETS] = {};
+    uint64_t max_ns = 0;
+    for (const auto& buffer : buffers_) {
+        for (int b = 0; b < TRACE_BUCKETS; ++b) {
+            buckets[b] += buffer->buckets[id][b].load(std::memory_order_relaxed);
+        }
+        max_ns = std::max(max_ns, buffer->max_ns[id].load(std::memory_order_relaxed));
+    }
+    for (uint64_t n : buckets) stats.count += n;
+    if (stats.count == 0) {
+        return stats;
+    }
+
+    // 第 q 分位所在的桶
+    auto quantile = [&](double q) {
+        uint64_t rank = static_cast<uint64_t>(q * (stats.count - 1));
+        uint64_t seen = 0;
+        for (int b = 0; b < TRACE_BUCKETS; ++b) {
+            seen += buckets[b];
+            if (seen > rank) return bucket_ms(b);
+        }
+        return bucket_ms(TRACE_BUCKETS - 1);
+    };
+    stats.max_ms = max_ns / 1e6;
+    stats.p50_ms = std::min(quantile(0.50), stats.max_ms);
+    stats.p99_ms = std::min(quantile(0.99), stats.max_ms);
+    return stats;
+}
+
+uint64_t Tracer::counter(const char* name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int id = find_id(name);
+    uint64_t total = 0;
+    for (const auto& buffer : buffers_) {
+        if (id >= 0) total += buffer->counters[id].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t Tracer::now_ns() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count();
+}
+
+Tracer::BufferHandle::~BufferHandle() {
+    if (buffer) {
+        buffer->in_use = false;
+    }
+}
+
+Tracer::ThreadBuffer& Tracer::local() {
+    thread_local BufferHandle handle;
+    if (!handle.buffer) {
+        handle.buffer = &acquire();
+    }
+    return *handle.buffer;
+}
+
+// 优先复用已结束线程的缓冲区，避免短命的线程（如流式解析）让缓冲区越来越多
+Tracer::ThreadBuffer& Tracer::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& buffer : buffers_) {
+        bool expected = false;
+        if (buffer->in_use.compare_exchange_strong(expected, true)) {
+            if (events_enabled_ && !buffer->events) {
+                buffer->events.reset(new TraceEvent[TRACE_EVENTS_PER_THREAD]);
+            }
+            return *buffer;
+        }
+    }
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->thread_id = static_cast<int>(buffers_.size()) + 1;
+    if (events_enabled_) {
+        buffer->events.reset(new TraceEvent[TRACE_EVENTS_PER_THREAD]);
+    }
+    buffers_.push_back(std::move(buffer));
+    return *buffers_.back();
+}
+
+// Chrome trace 事件格式：每个事件是一个 "X"（完整区间）事件，时间单位为微秒
+bool Tracer::write_trace_file() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FILE* file = std::fopen(trace_path_.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+    bool first = true;
+    for (const auto& buffer : buffers_) {
+        if (!buffer->events) {
+            continue;
+        }
+        uint64_t end = buffer->event_count.load(std::memory_order_acquire);
+        uint64_t begin = end > TRACE_EVENTS_PER_THREAD ? end - TRACE_EVENTS_PER_THREAD : 0;
+        for (uint64_t i = begin; i < end; ++i) {
+            const TraceEvent& event = buffer->events[i % TRACE_EVENTS_PER_THREAD];
+            std::fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                         first ? "" : ",", names_[event.id].c_str(), buffer->thread_id, event.start_ns / 1e3,
+                         event.duration_ns / 1e3);
+            first = false;
+        }
+    }
+    std::fputs("\n]}\n", file);
+    return std::fclose(file) == 0;
+}
+
+Tracer& tracer() {
+    static Tracer instance;
+    return instance;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 埋点：TRACE_SCOPE 统计一段代码的耗时，TRACE_COUNT 累加计数（如缓存命中）。
+// 每个线程只写自己的缓冲区（直方图、计数器和最近事件的环形缓冲），记录时不加锁；
+// 读取方（性能面板、退出时写出的 trace 文件）汇总所有线程的数据，结果可能略有滞后
+
+// 最多的名字数量，超出后新名字不再记录
+const int TRACE_MAX_NAMES = 64;
+// 直方图的桶：每个 2 的幂再分 4 个桶，覆盖 1ns 到约 18 分钟
+const int TRACE_BUCKETS = 160;
+// 开启 trace 文件时每个线程保留的最近事件数
+const size_t TRACE_EVENTS_PER_THREAD = 1 << 15;
+
+// 一个名字在所有线程上的耗时汇总
+struct SpanStats {
+    uint64_t count = 0;
+    double p50_ms = 0;
+    double p99_ms = 0;
+    double max_ms = 0;
+};
+
+class Tracer {
+public:
+    Tracer();
+    ~Tracer();  // 开启了 trace 文件时在这里写出
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    // 名字对应的 id，同一个名字总是得到同一个 id；名字已满时返回 -1。name 必须一直有效（通常是字面量）
+    int name_id(const char* name);
+
+    void record(int id, uint64_t start_ns, uint64_t end_ns);
+    void count(int id, uint64_t n = 1);
+
+    // 之后的每个事件都放入线程的环形缓冲，退出时以 Chrome trace 格式（chrome://tracing、Perfetto）写入 path。
+    // 应在其他线程开始记录之前调用
+    void enable_trace_file(const std::string& path);
+
+    SpanStats span(const char* name) const;
+    uint64_t counter(const char* name) const;
+
+    // 单调时钟的纳秒数，从 Tracer 创建时开始
+    uint64_t now_ns() const;
+
+private:
+    struct TraceEvent {
+        int id;
+        uint64_t start_ns;
+        uint64_t duration_ns;
+    };
+
+    // 一个线程的数据，只有该线程写入；线程结束后留给下一个新线程继续使用
+    struct ThreadBuffer {
+        std::atomic<bool> in_use{true};
+        int thread_id = 0;
+        std::atomic<uint32_t> buckets[TRACE_MAX_NAMES][TRACE_BUCKETS] = {};
+        std::atomic<uint64_t> max_ns[TRACE_MAX_NAMES] = {};
+        std::atomic<uint64_t> counters[TRACE_MAX_NAMES] = {};
+        std::unique_ptr<TraceEvent[]> events;  // 开启 trace 文件时才分配
+        std::atomic<uint64_t> event_count{0};
+    };
+
+    // thread_local 的句柄，线程结束时归还缓冲区
+    struct BufferHandle {
+        ThreadBuffer* buffer = nullptr;
+        ~BufferHandle();
+    };
+
+    ThreadBuffer& local();
+    ThreadBuffer& acquire();
+    int find_id(const char* name) const;
+    bool write_trace_file() const;
+
+    std::chrono::steady_clock::time_point epoch_;
+    mutable std::mutex mutex_;  // 保护名字表、缓冲区列表和 trace 文件设置
+    std::vector<std::string> names_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+    std::string trace_path_;
+    std::atomic<bool> events_enabled_{false};
+};
+
+// 全局的 Tracer；应在其他全局对象之前创建，退出时最后销毁
+Tracer& tracer();
+
+// 作用域计时，析构时记录耗时
+class TraceScope {
+public:
+    explicit TraceScope(int id) : id_(id), start_(tracer().now_ns()) {}
+    ~TraceScope() { tracer().record(id_, start_, tracer().now_ns()); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    int id_;
+    uint64_t start_;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// 统计从这里到作用域结束的耗时；名字只在第一次执行时查找
+#define TRACE_SCOPE(name)                                                          \
+    static const int TRACE_CONCAT(trace_id_, __LINE__) = tracer().name_id(name); \
+    TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(TRACE_CONCAT(trace_id_, __LINE__))
+
+#define TRACE_COUNT(name)                                      \
+    do {                                                       \
+        static const int trace_id = tracer().name_id(name);    \
+        tracer().count(trace_id);                              \
+    } while (0)
@@ -0,0 +1,66 @@
+#include "window_layout.h"
+
+#include <algorithm>
+#include <utility>
+
+WindowLayout::WindowLayout(int sidebar_width) : requested_width_(std::max(sidebar_width, MIN_SIDEBAR_WIDTH)) {}
+
+WindowLayout::~WindowLayout() {
+    if (sidebar_) delwin(sidebar_);
+    if (content_) delwin(content_);
+}
+
+void WindowLayout::create() {
+    rows_ = -1;  // 强制重新布局
+    update();
+}
+
+bool WindowLayout::update() {
+    if (LINES == rows_ && COLS == columns_) {
+        return false;
+    }
+    rows_ = LINES;
+    columns_ = COLS;
+    apply(LAYOUT_RESIZED);
+    return true;
+}
+
+bool WindowLayout::set_sidebar_width(int width) {
+    requested_width_ = std::max(width, MIN_SIDEBAR_WIDTH);
+    int before = sidebar_width_;
+    apply(0);
+    return sidebar_width_ != before;
+}
+
+void WindowLayout::on_change(Listener listener) {
+    listeners_.push_back(std::move(listener));
+}
+
+// 正文至少保留 MIN_CONTENT_WIDTH 列，终端太窄时先缩小侧边栏
+void WindowLayout::apply(unsigned changes) {
+    int sidebar_width = std::max(std::min(requested_width_, columns_ - 2 - MIN_CONTENT_WIDTH), 1);
+    int content_width = std::max(columns_ - sidebar_width - 2, 1);
+    if (sidebar_width != sidebar_width_) changes |= LAYOUT_SIDEBAR_WIDTH;
+    if (content_width != content_width_) changes |= LAYOUT_CONTENT_WIDTH;
+    if (changes == 0) {
+        return;
+    }
+    sidebar_width_ = sidebar_width;
+    content_width_ = content_width;
+
+    // 窗口直接重建，不用 wresize/mvwin：移动时中间状态可能超出屏幕而失败
+    if (sidebar_) delwin(sidebar_);
+    if (content_) delwin(content_);
+    int rows = std::max(rows_, 1);
+    sidebar_ = newwin(rows, sidebar_width_, 0, 0);
+    content_ = newwin(rows, content_width_, 0, std::min(sidebar_width_ + 2, std::max(columns_ - 1, 0)));
+    for (const Listener& listener : listeners_) {
+        listener(changes);
+    }
+}
+
+void WindowLayout::draw_separator() const {
+    werase(stdscr);
+    mvwvline(stdscr, 0, sidebar_width_, ACS_VLINE, rows_);  // 使用 ncurses 的图形字符绘制线
+    wnoutrefresh(stdscr);
+}
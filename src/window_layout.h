@@ -0,0 +1,62 @@
+#pragma once
+
+#include <ncurses.h>
+#include <functional>
+#include <vector>
+
+// 侧边栏的默认宽度和允许的范围（列）；侧边栏和正文之间是一列分隔线和一列空白
+const int DEFAULT_SIDEBAR_WIDTH = 23;
+const int MIN_SIDEBAR_WIDTH = 12;
+const int MIN_CONTENT_WIDTH = 20;
+
+// 布局变化的种类，作为监听者的参数
+enum LayoutChange : unsigned {
+    LAYOUT_RESIZED = 1 << 0,        // 终端大小变化
+    LAYOUT_SIDEBAR_WIDTH = 1 << 1,  // 侧边栏宽度变化，标签需要按新宽度截断
+    LAYOUT_CONTENT_WIDTH = 1 << 2,  // 正文宽度变化，折行结果需要重新计算
+};
+
+// 窗口布局：拥有侧边栏和正文两个窗口，缓存终端大小和各部分的位置。
+// 终端大小变化（SIGWINCH 后 ncurses 在 getch 中更新 LINES/COLS 并返回 KEY_RESIZE）
+// 或侧边栏宽度变化时才重新计算几何、重建窗口并通知监听者；平时绘制只读取缓存的值
+class WindowLayout {
+public:
+    using Listener = std::function<void(unsigned changes)>;
+
+    explicit WindowLayout(int sidebar_width = DEFAULT_SIDEBAR_WIDTH);
+    ~WindowLayout();
+
+    WindowLayout(const WindowLayout&) = delete;
+    WindowLayout& operator=(const WindowLayout&) = delete;
+
+    // 按当前终端大小创建窗口，在 initscr 之后调用
+    void create();
+    // 终端大小变化时重新布局，没有变化时只比较两个整数；返回是否变化
+    bool update();
+    // 设置侧边栏宽度，终端放不下时按能放下的最大宽度显示；返回实际宽度是否变化
+    bool set_sidebar_width(int width);
+    void on_change(Listener listener);
+
+    WINDOW* sidebar() const { return sidebar_; }
+    WINDOW* content() const { return content_; }
+    int rows() const { return rows_; }
+    int sidebar_width() const { return sidebar_width_; }
+    int content_width() const { return content_width_; }
+    // 侧边栏标签的标题宽度，留出 "..." 的位置
+    int label_columns() const { return sidebar_width_ - 3; }
+
+    // 在 stdscr 上清除旧的内容并画分隔线
+    void draw_separator() const;
+
+private:
+    void apply(unsigned changes);
+
+    int requested_width_;  // 用户设置的侧边栏宽度，终端变宽后恢复到这个宽度
+    int rows_ = 0;
+    int columns_ = 0;
+    int sidebar_width_ = 0;
+    int content_width_ = 0;
+    WINDOW* sidebar_ = nullptr;
+    WINDOW* content_ = nullptr;
+    std::vector<Listener> listeners_;
+};
@@ -0,0 +1,94 @@
+// AuthSession 的刷新时机：模拟后端签发有效期很短的 JWT，后台线程不能在每次刷新后立即再次登录。
+// 后端地址在启动时从 MINIBLOG_URL 读取，所以先启动模拟后端，再以 --client 重新执行自身作为客户端
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include "auth_session.h"
+#include "mock_server.h"
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                                     \
+    do {                                                                                     \
+        if (!(condition)) {                                                                  \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                                      \
+        }                                                                                    \
+    } while (0)
+
+void test_refresh_lead() {
+    using std::chrono::seconds;
+    CHECK(refresh_lead(seconds(3600), seconds(60)) == seconds(60));
+    CHECK(refresh_lead(seconds(60), seconds(60)) == seconds(30));  // 有效期不超过余量时取一半
+    CHECK(refresh_lead(seconds(4), seconds(60)) == seconds(2));
+    CHECK(refresh_lead(seconds(0), seconds(60)) == seconds(0));
+    CHECK(refresh_lead(seconds(-5), seconds(60)) == seconds(0));
+}
+
+// 客户端进程：登录后让后台线程运行 3 秒，令牌有效期 4 秒
+int run_client() {
+    char path[] = "/tmp/miniblog_token_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return 1;
+    }
+    close(fd);
+    {
+        AuthSession session(path);
+        CHECK(session.login("user", "password"));
+        session.start();
+        std::this_thread::sleep_for(std::chrono::seconds(3));
+        CHECK(session.logged_in());
+        CHECK(session.last_error().empty());
+        session.stop();
+    }
+    unlink(path);
+    return failures == 0 ? 0 : 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--client") == 0) {
+        return run_client();
+    }
+
+    test_refresh_lead();
+
+    MockConfig config;
+    config.posts = 10;
+    config.rtt_ms = 0;
+    config.feed = false;
+    config.token_ttl_seconds = 4;
+    MockBlogServer server(config);
+    if (!server.start()) {
+        std::fprintf(stderr, "failed to start mock server\n");
+        return 1;
+    }
+
+    setenv("MINIBLOG_URL", server.url().c_str(), 1);
+    pid_t pid = fork();
+    if (pid == 0) {
+        execl("/proc/self/exe", argv[0], "--client", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // 第一次登录，2 秒时（有效期的一半）刷新一次；之后至少间隔 5 秒才会再刷新
+    uint64_t logins = server.request_count("POST /login");
+    std::printf("logins in 3s with a 4s token: %llu\n", static_cast<unsigned long long>(logins));
+    CHECK(logins >= 2 && logins <= 3);
+
+    server.stop();
+    return failures == 0 ? 0 : 1;
+}